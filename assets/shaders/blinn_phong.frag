@@ -10,9 +10,23 @@ struct material_data {
     uint mode;
 };
 
+// see sl::game::material_element
+struct material_element {
+    vec4 diffuse_color;
+    vec4 specular_color;
+
+    float shininess;
+    uint mode;
+    uint diffuse_array;
+    uint diffuse_layer;
+    uint specular_array;
+    uint specular_layer;
+};
+
 struct material {
     vec3 diffuse;
     vec3 specular;
+    float shininess;
 };
 
 struct directional_light {
@@ -55,6 +69,12 @@ uniform vec3 u_view_pos;
 
 uniform material_data u_material;
 
+// materials of instanced draws, textures are packed by sl::game::texture_arrays
+uniform sampler2DArray u_material_arrays[4];
+layout(std430, binding = 6) readonly buffer b_materials {
+    material_element b_materials_data[];
+};
+
 uniform uint u_directional_light_size = 0;
 layout(std430, binding = 0) readonly buffer b_directional_lights {
     directional_light b_directional_lights_data[];
@@ -70,9 +90,22 @@ layout(std430, binding = 2) readonly buffer b_spot_lights {
     spot_light b_spot_lights_data[];
 };
 
+// clustered lights, see sl::game::render::clustered_lights, all lights are shaded if grid is zero
+uniform uvec3 u_cluster_grid = uvec3(0);
+uniform float u_cluster_near;
+uniform float u_cluster_depth_scale;
+layout(std430, binding = 4) readonly buffer b_light_clusters {
+    uvec4 b_light_clusters_data[]; // point offset, point count, spot offset, spot count
+};
+layout(std430, binding = 5) readonly buffer b_light_indices {
+    uint b_light_indices_data[];
+};
+
 in vec3 msg_frag_pos;
 in vec3 msg_normal;
 in vec2 msg_tex_coords;
+in vec4 msg_clip_pos;
+flat in uint msg_material_index;
 
 out vec4 frag_color;
 
@@ -86,7 +119,7 @@ vec3 calc_directional_light(directional_light light, material material, vec3 nor
 
     const vec3 reflect_direction = reflect(-light_direction, normal);
     const float specular_angle = max(dot(view_direction, reflect_direction), 0.0f);
-    const vec3 specular = light.specular * material.specular * pow(specular_angle, u_material.shininess);
+    const vec3 specular = light.specular * material.specular * pow(specular_angle, material.shininess);
 
     return ambient + diffuse + specular;
 }
@@ -101,7 +134,7 @@ vec3 calc_point_light(point_light light, material material, vec3 normal, vec3 fr
 
     const vec3 reflect_direction = reflect(-light_direction, normal);
     const float specular_angle = max(dot(view_direction, reflect_direction), 0.0f);
-    const vec3 specular = light.specular * material.specular * pow(specular_angle, u_material.shininess);
+    const vec3 specular = light.specular * material.specular * pow(specular_angle, material.shininess);
 
     const float distance = length(light.position - frag_pos);
     const float attenuation = 1.0f / (
@@ -123,7 +156,7 @@ vec3 calc_spot_light(spot_light light, material material, vec3 normal, vec3 frag
 
     const vec3 reflect_direction = reflect(-light_direction, normal);
     const float specular_angle = max(dot(view_direction, reflect_direction), 0.0f);
-    const vec3 specular = light.specular * material.specular * pow(specular_angle, u_material.shininess);
+    const vec3 specular = light.specular * material.specular * pow(specular_angle, material.shininess);
 
     const float distance = length(light.position - frag_pos);
     const float attenuation = 1.0f / (
@@ -139,13 +172,46 @@ vec3 calc_spot_light(spot_light light, material material, vec3 normal, vec3 frag
     return (ambient + diffuse + specular) * attenuation * intensity;
 }
 
-void main() {
+// implicit derivatives are undefined in non-uniform control flow, so gradients are taken in main and passed down
+vec3 sample_material_arrays(uint array, uint layer, vec2 tex_coords_dx, vec2 tex_coords_dy) {
+    const vec3 coords = vec3(msg_tex_coords, float(layer));
+    // samplers are indexed by constants only, since array may differ between instances of one draw
+    switch (array) {
+        case 0u: return textureGrad(u_material_arrays[0], coords, tex_coords_dx, tex_coords_dy).rgb;
+        case 1u: return textureGrad(u_material_arrays[1], coords, tex_coords_dx, tex_coords_dy).rgb;
+        case 2u: return textureGrad(u_material_arrays[2], coords, tex_coords_dx, tex_coords_dy).rgb;
+        default: return textureGrad(u_material_arrays[3], coords, tex_coords_dx, tex_coords_dy).rgb;
+    }
+}
+
+material instance_material(material_element element, vec2 tex_coords_dx, vec2 tex_coords_dy) {
+    const bool material_has_diffuse_texture = (element.mode & 1u) != 0u;
+    const bool material_has_specular_texture = (element.mode & 2u) != 0u;
+
+    material material;
+    material.diffuse = material_has_diffuse_texture ? sample_material_arrays(element.diffuse_array, element.diffuse_layer, tex_coords_dx, tex_coords_dy) : element.diffuse_color.xyz;
+    material.specular = material_has_specular_texture ? sample_material_arrays(element.specular_array, element.specular_layer, tex_coords_dx, tex_coords_dy) : element.specular_color.xyz;
+    material.shininess = element.shininess;
+    return material;
+}
+
+material uniform_material() {
     const bool material_has_diffuse_texture = (u_material.mode & 1u) != 0u;
     const bool material_has_specular_texture = (u_material.mode & 2u) != 0u;
 
     material material;
     material.diffuse = material_has_diffuse_texture ? texture(u_material.diffuse, msg_tex_coords).rgb : u_material.diffuse_color.xyz;
     material.specular = material_has_specular_texture ? texture(u_material.specular, msg_tex_coords).rgb : u_material.specular_color.xyz;
+    material.shininess = u_material.shininess;
+    return material;
+}
+
+void main() {
+    const vec2 tex_coords_dx = dFdx(msg_tex_coords);
+    const vec2 tex_coords_dy = dFdy(msg_tex_coords);
+    const material material = msg_material_index == 0xFFFFFFFFu
+            ? uniform_material()
+            : instance_material(b_materials_data[msg_material_index], tex_coords_dx, tex_coords_dy);
 
     const vec3 normal = normalize(msg_normal);
     const vec3 view_direction = normalize(u_view_pos - msg_frag_pos);
@@ -155,11 +221,28 @@ void main() {
     for (uint i = 0; i < u_directional_light_size; ++i) {
         result += calc_directional_light(b_directional_lights_data[i], material, normal, view_direction);
     }
-    for (uint i = 0; i < u_point_light_size; ++i) {
-        result += calc_point_light(b_point_lights_data[i], material, normal, msg_frag_pos, view_direction);
-    }
-    for (uint i = 0; i < u_spot_light_size; ++i) {
-        result += calc_spot_light(b_spot_lights_data[i], material, normal, msg_frag_pos, view_direction);
+
+    if (u_cluster_grid == uvec3(0)) {
+        for (uint i = 0; i < u_point_light_size; ++i) {
+            result += calc_point_light(b_point_lights_data[i], material, normal, msg_frag_pos, view_direction);
+        }
+        for (uint i = 0; i < u_spot_light_size; ++i) {
+            result += calc_spot_light(b_spot_lights_data[i], material, normal, msg_frag_pos, view_direction);
+        }
+    } else {
+        const vec2 ndc = msg_clip_pos.xy / msg_clip_pos.w;
+        const uvec2 cluster_tile = uvec2(clamp(floor((ndc * 0.5 + 0.5) * vec2(u_cluster_grid.xy)), vec2(0), vec2(u_cluster_grid.xy - 1u)));
+        const float depth = msg_clip_pos.w; // view space depth for perspective projection
+        const float slice_position = depth <= u_cluster_near ? 0.0 : floor(log(depth / u_cluster_near) * u_cluster_depth_scale);
+        const uint cluster_slice = uint(clamp(slice_position, 0.0, float(u_cluster_grid.z - 1u)));
+        const uvec4 cluster = b_light_clusters_data[cluster_tile.x + u_cluster_grid.x * (cluster_tile.y + u_cluster_grid.y * cluster_slice)];
+
+        for (uint i = cluster.x; i < cluster.x + cluster.y; ++i) {
+            result += calc_point_light(b_point_lights_data[b_light_indices_data[i]], material, normal, msg_frag_pos, view_direction);
+        }
+        for (uint i = cluster.z; i < cluster.z + cluster.w; ++i) {
+            result += calc_spot_light(b_spot_lights_data[b_light_indices_data[i]], material, normal, msg_frag_pos, view_direction);
+        }
     }
 
     frag_color = vec4(result, 1.0);
@@ -4,6 +4,19 @@ uniform mat4 u_model; // part of u_transform
 uniform mat3 u_it_model; // for normals
 uniform mat4 u_transform;
 
+struct instance {
+    mat4 model;
+    mat4 it_model; // upper 3x3 is used for normals
+    uint material_index;
+};
+
+// instanced draws read model matrices and materials per instance, see sl::game::instance_element
+uniform bool u_instanced = false;
+uniform mat4 u_view_projection; // instanced only
+layout(std430, binding = 3) readonly buffer b_instances {
+    instance b_instances_data[];
+};
+
 layout(location = 0) in vec3 in_vert;
 layout(location = 1) in vec3 in_normal;
 layout(location = 2) in vec2 in_tex_coords;
@@ -11,11 +24,23 @@ layout(location = 2) in vec2 in_tex_coords;
 out vec3 msg_frag_pos;
 out vec3 msg_normal;
 out vec2 msg_tex_coords;
+out vec4 msg_clip_pos;
+flat out uint msg_material_index; // into b_materials, all ones for u_material
 
 void main() {
-    gl_Position = u_transform * vec4(in_vert, 1.0);
-    msg_frag_pos = vec3(u_model * vec4(in_vert, 1.0));
-    msg_normal = u_it_model * in_normal;
+    if (u_instanced) {
+        const instance inst = b_instances_data[gl_BaseInstance + gl_InstanceID];
+        gl_Position = u_view_projection * inst.model * vec4(in_vert, 1.0);
+        msg_frag_pos = vec3(inst.model * vec4(in_vert, 1.0));
+        msg_normal = mat3(inst.it_model) * in_normal;
+        msg_material_index = inst.material_index;
+    } else {
+        gl_Position = u_transform * vec4(in_vert, 1.0);
+        msg_frag_pos = vec3(u_model * vec4(in_vert, 1.0));
+        msg_normal = u_it_model * in_normal;
+        msg_material_index = 0xFFFFFFFFu;
+    }
     msg_tex_coords = in_tex_coords;
+    msg_clip_pos = gl_Position;
 }
 
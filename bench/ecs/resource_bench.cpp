@@ -0,0 +1,84 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/ecs/resource.hpp"
+
+#include <sl/meta/storage/unique_string_convenience.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace sl::ecs {
+namespace {
+
+using meta::operator""_ufs;
+
+constexpr std::size_t id_count = 4096;
+
+// lookup before resource_index: one lock around the whole map, as require takes resource::mutex_
+template <typename ReferenceT>
+class mutex_index {
+public:
+    [[nodiscard]] meta::maybe<ReferenceT> lookup(meta::unique_string id) const {
+        std::lock_guard lock{ mutex_ };
+        if (const auto it = references_.find(id); it != references_.end()) {
+            return it->second;
+        }
+        return meta::null;
+    }
+
+    void publish(meta::unique_string id, ReferenceT reference) {
+        std::lock_guard lock{ mutex_ };
+        references_.insert_or_assign(id, std::move(reference));
+    }
+
+private:
+    mutable std::mutex mutex_;
+    tsl::robin_map<meta::unique_string, ReferenceT> references_;
+};
+
+// shared by all threads of a run, filled once
+template <typename IndexT>
+struct lookup_state {
+    meta::unique_string_storage uss{ meta::unique_string_storage::init_type{} };
+    std::vector<meta::unique_string> ids;
+    IndexT index{};
+
+    lookup_state() {
+        ids.reserve(id_count);
+        for (std::size_t i = 0; i < id_count; ++i) {
+            ids.push_back("id.{}"_ufs(i)(uss));
+            index.publish(ids.back(), static_cast<int>(i));
+        }
+    }
+
+    static lookup_state& instance() {
+        static lookup_state state;
+        return state;
+    }
+};
+
+// every thread walks all ids from its own offset, so threads hit different shards at the same time
+template <typename IndexT>
+void lookup_contended(benchmark::State& state) {
+    const lookup_state<IndexT>& shared = lookup_state<IndexT>::instance();
+    std::size_t i = static_cast<std::size_t>(state.thread_index()) * (id_count / 16);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared.index.lookup(shared.ids[i % id_count]));
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_resource_index_lookup(benchmark::State& state) { lookup_contended<detail::resource_index<int>>(state); }
+void BM_mutex_index_lookup(benchmark::State& state) { lookup_contended<mutex_index<int>>(state); }
+
+BENCHMARK(BM_resource_index_lookup)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_mutex_index_lookup)->ThreadRange(1, 16)->UseRealTime();
+
+} // namespace
+} // namespace sl::ecs
@@ -0,0 +1,66 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/buffer.hpp"
+#include "sl/game/render/light/component.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+// every entity has a point light and a transform, output is plain memory standing in for the mapped ssbo
+struct light_fill_scene {
+    ecs::layer layer{};
+    const basis world{};
+    std::vector<entt::entity> entities;
+    std::vector<render::point_light_element> output;
+
+    explicit light_fill_scene(std::size_t entity_count) : output(entity_count) {
+        entities.reserve(entity_count);
+        for (std::size_t i = 0; i < entity_count; ++i) {
+            const entt::entity entity = layer.registry.create();
+            const auto f = static_cast<float>(i);
+            layer.registry.emplace<render::point_light>(entity, render::point_light{ .constant = f });
+            layer.registry.emplace<transform>(entity, transform{ .tr{ f, 0.0f, -f } });
+            entities.push_back(entity);
+        }
+    }
+};
+
+void BM_fill_ssbo_serial(benchmark::State& state) {
+    light_fill_scene scene{ static_cast<std::size_t>(state.range(0)) };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            fill_ssbo(scene.layer, scene.world, std::span{ scene.output }, std::span{ scene.entities })
+        );
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// second argument is amount of cores, the calling thread included
+void BM_fill_ssbo_parallel(benchmark::State& state) {
+    light_fill_scene scene{ static_cast<std::size_t>(state.range(0)) };
+    worker_pool workers{ static_cast<std::size_t>(state.range(1)) - 1 };
+    fill_ssbo_chunks<render::point_light_element> chunks;
+    const std::span<const entt::entity> entities{ scene.entities };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            fill_ssbo(scene.layer, scene.world, std::span{ scene.output }, entities, workers, chunks)
+        );
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_fill_ssbo_serial)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_fill_ssbo_parallel)
+    ->ArgsProduct({ { 100'000, 1'000'000 }, { 1, 2, 4, 8, 16 } })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace sl::game
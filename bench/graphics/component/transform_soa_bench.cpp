@@ -0,0 +1,76 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/component/transform_soa.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+transform make_transform(std::size_t i) {
+    const float f = static_cast<float>(i % 64);
+    return transform{
+        .tr{ f, -0.5f * f, 2.0f },
+        .rot = glm::normalize(glm::quat{ 1.0f, 0.1f * f, 0.2f, -0.3f * f }),
+        .s{ 1.0f + 0.1f * f, 2.0f, 0.5f },
+    };
+}
+
+// combine and matrix() of transform one element at a time, as world matrices were computed before transform_soa
+void BM_combine_scalar(benchmark::State& state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    std::vector<transform> parent;
+    std::vector<transform> local;
+    for (std::size_t i = 0; i < size; ++i) {
+        parent.push_back(make_transform(i));
+        local.push_back(make_transform(size - i));
+    }
+    std::vector<transform> out(size);
+    std::vector<glm::mat4> models(size);
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < size; ++i) {
+            out[i] = combine(parent[i], local[i]);
+            models[i] = out[i].matrix();
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::DoNotOptimize(models.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// second argument is max_lane_count, kernels the cpu does not support fall back to narrower ones
+void BM_transform_soa_combine(benchmark::State& state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const auto max_lane_count = static_cast<std::size_t>(state.range(1));
+    if (max_lane_count > combine_lane_count()) {
+        state.SkipWithError("kernel is not supported by this cpu");
+        return;
+    }
+    transform_soa parent;
+    transform_soa local;
+    for (std::size_t i = 0; i < size; ++i) {
+        parent.push_back(make_transform(i));
+        local.push_back(make_transform(size - i));
+    }
+    transform_soa out;
+    std::vector<glm::mat4> models(size);
+
+    for (auto _ : state) {
+        combine(parent, local, out, models, max_lane_count);
+        benchmark::DoNotOptimize(out.tr_x.data());
+        benchmark::DoNotOptimize(models.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_combine_scalar)->Arg(1'024)->Arg(65'536);
+BENCHMARK(BM_transform_soa_combine)->ArgsProduct({ { 1'024, 65'536 }, { 1, 4, 8 } });
+
+} // namespace
+} // namespace sl::game
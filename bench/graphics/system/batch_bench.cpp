@@ -0,0 +1,112 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/component/vertex.hpp"
+#include "sl/game/graphics/system/batch.hpp"
+
+#include <sl/meta/storage/unique_string_convenience.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+using meta::operator""_ufs;
+
+// static props spread over a few shaders and many vertices, like an imported scene
+struct batch_scene {
+    static constexpr std::size_t shader_count = 4;
+    static constexpr std::size_t vertex_count = 64;
+
+    meta::unique_string_storage uss{ meta::unique_string_storage::init_type{} };
+    ecs::layer layer{};
+    std::vector<meta::unique_string> shader_ids;
+    std::vector<meta::unique_string> vertex_ids;
+    std::vector<entt::entity> entities;
+
+    batch_scene() {
+        for (std::size_t i = 0; i < shader_count; ++i) {
+            shader_ids.push_back("shader.{}"_ufs(i)(uss));
+        }
+        for (std::size_t i = 0; i < vertex_count; ++i) {
+            vertex_ids.push_back("vertex.{}"_ufs(i)(uss));
+        }
+    }
+
+    void populate(std::size_t entity_count) {
+        entities.reserve(entity_count);
+        for (std::size_t i = 0; i < entity_count; ++i) {
+            const entt::entity entity = layer.registry.create();
+            layer.registry.emplace<shader::id>(entity, shader_ids[i % shader_count]);
+            layer.registry.emplace<vertex::id>(entity, vertex_ids[(i / shader_count) % vertex_count]);
+            entities.push_back(entity);
+        }
+    }
+};
+
+// what graphics_system::execute did before draw_batch_cache, every frame
+void BM_draw_batch_rebuild(benchmark::State& state) {
+    using vertex_to_entities = tsl::robin_map</* vertex */ meta::unique_string, std::vector<entt::entity>>;
+    using shader_to_vertices_to_entities = tsl::robin_map</* shader */ meta::unique_string, vertex_to_entities>;
+
+    const auto entity_count = static_cast<std::size_t>(state.range(0));
+    batch_scene scene;
+    scene.populate(entity_count);
+
+    for (auto _ : state) {
+        shader_to_vertices_to_entities sve_map;
+        const auto entities = scene.layer.registry.view<shader::id, vertex::id>();
+        for (const auto& [entity, shader, vertex] : entities.each()) {
+            sve_map[shader.id][vertex.id].push_back(entity);
+        }
+        benchmark::DoNotOptimize(sve_map);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// frame without changes, the common case for static props
+void BM_draw_batch_cache_unchanged(benchmark::State& state) {
+    const auto entity_count = static_cast<std::size_t>(state.range(0));
+    batch_scene scene;
+    const draw_batch_cache::ptr_type batches = draw_batch_cache::make(scene.layer.registry);
+    scene.populate(entity_count);
+    std::ignore = batches->prepare();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&batches->prepare());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// frame where one in a hundred entities switches its vertex, touched batches are re-sorted
+void BM_draw_batch_cache_changed(benchmark::State& state) {
+    const auto entity_count = static_cast<std::size_t>(state.range(0));
+    batch_scene scene;
+    const draw_batch_cache::ptr_type batches = draw_batch_cache::make(scene.layer.registry);
+    scene.populate(entity_count);
+    std::ignore = batches->prepare();
+
+    std::size_t frame = 0;
+    for (auto _ : state) {
+        ++frame;
+        for (std::size_t i = frame % 100; i < scene.entities.size(); i += 100) {
+            const meta::unique_string vertex_id = scene.vertex_ids[(i + frame) % batch_scene::vertex_count];
+            scene.layer.registry.replace<vertex::id>(scene.entities[i], vertex_id);
+        }
+        benchmark::DoNotOptimize(&batches->prepare());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_draw_batch_rebuild)->Arg(1'000)->Arg(10'000)->Arg(100'000);
+BENCHMARK(BM_draw_batch_cache_unchanged)->Arg(1'000)->Arg(10'000)->Arg(100'000);
+BENCHMARK(BM_draw_batch_cache_changed)->Arg(1'000)->Arg(10'000)->Arg(100'000);
+
+} // namespace
+} // namespace sl::game
@@ -0,0 +1,85 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/spatial.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+// dynamic entities on a grid, every one of them moves a little each frame
+struct spatial_scene {
+    entt::registry registry{};
+    spatial_index::ptr_type index = spatial_index::make(registry);
+    std::vector<entt::entity> entities;
+    std::size_t frame = 0;
+
+    explicit spatial_scene(std::size_t entity_count) {
+        const auto side = static_cast<std::size_t>(std::ceil(std::cbrt(static_cast<double>(entity_count))));
+        entities.reserve(entity_count);
+        for (std::size_t i = 0; i < entity_count; ++i) {
+            const glm::vec3 position{ i % side, (i / side) % side, i / (side * side) };
+            const entt::entity entity = registry.create();
+            registry.emplace<aabb>(entity, aabb{ .min{ -0.4f }, .max{ 0.4f } });
+            registry.emplace<transform>(entity, transform{ .tr = 2.0f * position });
+            entities.push_back(entity);
+        }
+    }
+
+    // offsets are small compared to the grid step, so that refitting does not make the tree too loose
+    void move_all() {
+        ++frame;
+        const float offset = (frame % 2 == 0 ? 0.05f : -0.05f);
+        for (const entt::entity entity : entities) {
+            registry.patch<transform>(entity, [offset](transform& tf) { tf.tr.x += offset; });
+        }
+    }
+};
+
+// second argument tells whether a worker_pool is used
+std::unique_ptr<worker_pool> make_workers(const benchmark::State& state) {
+    return state.range(1) != 0 ? std::make_unique<worker_pool>() : nullptr;
+}
+
+void BM_spatial_index_refit(benchmark::State& state) {
+    spatial_scene scene{ static_cast<std::size_t>(state.range(0)) };
+    const std::unique_ptr<worker_pool> workers = make_workers(state);
+    scene.index->update(workers.get());
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        scene.move_all();
+        state.ResumeTiming();
+        scene.index->update(workers.get());
+    }
+    state.counters["refit_count"] = static_cast<double>(scene.index->refit_count());
+    state.counters["rebuild_count"] = static_cast<double>(scene.index->rebuild_count());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_spatial_index_rebuild(benchmark::State& state) {
+    spatial_scene scene{ static_cast<std::size_t>(state.range(0)) };
+    const std::unique_ptr<worker_pool> workers = make_workers(state);
+    scene.index->update(workers.get());
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        scene.move_all();
+        state.ResumeTiming();
+        scene.index->rebuild(workers.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_spatial_index_refit)->ArgsProduct({ { 100'000 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_spatial_index_rebuild)->ArgsProduct({ { 100'000 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace sl::game
@@ -0,0 +1,83 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/transform.hpp"
+#include "sl/game/update/component.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+// tree with every node having local_transform and world_matrix, like an imported glTF scene
+struct transform_scene {
+    static constexpr std::size_t branching = 4;
+
+    ecs::layer layer{};
+    entt::entity root = entt::null;
+    time clock_time{};
+
+    explicit transform_scene(std::size_t entity_count) {
+        std::vector<entt::entity> entities;
+        entities.reserve(entity_count);
+        for (std::size_t i = 0; i < entity_count; ++i) {
+            const entt::entity entity = layer.registry.create();
+            const float angle = 0.001f * static_cast<float>(i);
+            layer.registry.emplace<local_transform>(
+                entity,
+                transform{
+                    .tr{ static_cast<float>(i % 7), 0.0f, 1.0f },
+                    .rot = glm::angleAxis(angle, glm::vec3{ 0.0f, 1.0f, 0.0f }),
+                }
+            );
+            layer.registry.emplace<world_matrix>(entity);
+            if (i != 0) {
+                node::attach_child(layer, entities[(i - 1) / branching], entity);
+            }
+            entities.push_back(entity);
+        }
+        root = entities.front();
+    }
+
+    // moving the root makes every transform of the tree change, which is the worst case of a frame
+    void move_root() {
+        layer.registry.patch<local_transform>(root, [](local_transform& root_tf) { root_tf.set_dirty(true); });
+    }
+};
+
+void BM_local_transform_serial(benchmark::State& state) {
+    transform_scene scene{ static_cast<std::size_t>(state.range(0)) };
+    local_transform_system(scene.layer, scene.clock_time.calculate());
+
+    for (auto _ : state) {
+        scene.move_root();
+        local_transform_system(scene.layer, scene.clock_time.calculate());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// second argument is amount of cores, the calling thread included
+void BM_local_transform_parallel(benchmark::State& state) {
+    transform_scene scene{ static_cast<std::size_t>(state.range(0)) };
+    worker_pool workers{ static_cast<std::size_t>(state.range(1)) - 1 };
+    local_transform_system(scene.layer, scene.clock_time.calculate(), workers);
+
+    for (auto _ : state) {
+        scene.move_root();
+        local_transform_system(scene.layer, scene.clock_time.calculate(), workers);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_local_transform_serial)->Arg(200'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_local_transform_parallel)
+    ->ArgsProduct({ { 200'000 }, { 1, 2, 4, 8, 16 } })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace sl::game
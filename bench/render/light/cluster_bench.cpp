@@ -0,0 +1,85 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/render/light/cluster.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace sl::game::render {
+namespace {
+
+// lights scattered in front of the camera, half of them points and half spots, radii of about 2 to 6 units
+struct light_scene {
+    std::vector<point_light_element> points;
+    std::vector<spot_light_element> spots;
+    camera_frame a_camera_frame{
+        .position{ 0.0f },
+        .projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f),
+        .view = glm::lookAt(glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }),
+    };
+
+    explicit light_scene(std::size_t light_count) {
+        std::mt19937 engine{ 42 };
+        std::uniform_real_distribution<float> x{ -50.0f, 50.0f };
+        std::uniform_real_distribution<float> y{ -10.0f, 10.0f };
+        std::uniform_real_distribution<float> z{ -100.0f, -1.0f };
+        std::uniform_real_distribution<float> quadratic{ 7.0f, 64.0f };
+
+        for (std::size_t i = 0; i < light_count; ++i) {
+            const glm::vec3 position{ x(engine), y(engine), z(engine) };
+            if (i % 2 == 0) {
+                points.push_back(point_light_element{
+                    .position = position,
+                    .ambient{ 1.0f },
+                    .diffuse{ 1.0f },
+                    .specular{ 1.0f },
+                    .constant = 1.0f,
+                    .linear = 0.0f,
+                    .quadratic = quadratic(engine),
+                });
+            } else {
+                spots.push_back(spot_light_element{
+                    .position = position,
+                    .direction{ 0.0f, 0.0f, -1.0f },
+                    .ambient{ 1.0f },
+                    .diffuse{ 1.0f },
+                    .specular{ 1.0f },
+                    .constant = 1.0f,
+                    .linear = 0.0f,
+                    .quadratic = quadratic(engine),
+                    .cutoff = 0.9f,
+                    .outer_cutoff = 0.8f,
+                });
+            }
+        }
+    }
+};
+
+// second argument tells whether a worker_pool is used
+void BM_clustered_lights_assign(benchmark::State& state) {
+    const light_scene scene{ static_cast<std::size_t>(state.range(0)) };
+    const std::unique_ptr<worker_pool> workers = state.range(1) != 0 ? std::make_unique<worker_pool>() : nullptr;
+    clustered_lights lights;
+    lights.assign(scene.points, scene.spots, scene.a_camera_frame, workers.get());
+
+    for (auto _ : state) {
+        lights.assign(scene.points, scene.spots, scene.a_camera_frame, workers.get());
+        benchmark::DoNotOptimize(lights.indices().data());
+    }
+    const auto index_count = static_cast<double>(lights.indices().size());
+    state.counters["indices_per_light"] = index_count / static_cast<double>(state.range(0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_clustered_lights_assign)->ArgsProduct({ { 1'000, 10'000 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
+
+} // namespace
+} // namespace sl::game::render
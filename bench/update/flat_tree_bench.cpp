@@ -0,0 +1,183 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/update/component.hpp"
+#include "sl/game/update/flat_tree.hpp"
+#include "sl/game/update/system.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+// bytes requested from the global operator new, which is replaced below to count them
+std::atomic<std::size_t> allocated_byte_count{ 0 };
+
+constexpr std::size_t branching = 4;
+
+// parent and child indices of a complete tree, in depth-first order as a scene importer attaches them,
+// which is the order where flat_tree appends at the end of the array
+std::vector<std::pair<std::size_t, std::size_t>> depth_first_edges(std::size_t entity_count) {
+    std::vector<std::pair<std::size_t, std::size_t>> edges;
+    edges.reserve(entity_count);
+    std::vector<std::size_t> stack{ 0 };
+    while (!stack.empty()) {
+        const std::size_t parent = stack.back();
+        stack.pop_back();
+        for (std::size_t k = branching; k > 0; --k) {
+            if (const std::size_t child = parent * branching + k; child < entity_count) {
+                stack.push_back(child);
+            }
+        }
+        if (parent != 0) {
+            edges.emplace_back((parent - 1) / branching, parent);
+        }
+    }
+    return edges;
+}
+
+// entities are created up front, so that only the hierarchy itself is counted
+std::vector<entt::entity> create_entities(ecs::layer& layer, std::size_t entity_count) {
+    std::vector<entt::entity> entities(entity_count);
+    layer.registry.create(entities.begin(), entities.end());
+    return entities;
+}
+
+using edge_span = std::span<const std::pair<std::size_t, std::size_t>>;
+
+void build_nodes(ecs::layer& layer, std::span<const entt::entity> entities, edge_span edges) {
+    for (const auto [parent, child] : edges) {
+        node::attach_child(layer, entities[parent], entities[child]);
+    }
+}
+
+void build_flat_tree(flat_tree& tree, std::span<const entt::entity> entities, edge_span edges) {
+    for (const auto [parent, child] : edges) {
+        tree.attach_child(entities[parent], entities[child]);
+    }
+}
+
+void BM_node_memory(benchmark::State& state) {
+    const auto entity_count = static_cast<std::size_t>(state.range(0));
+    const auto edges = depth_first_edges(entity_count);
+    std::size_t byte_count = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ecs::layer layer{};
+        const std::vector<entt::entity> entities = create_entities(layer, entity_count);
+        const std::size_t allocated_before = allocated_byte_count.load(std::memory_order_relaxed);
+        state.ResumeTiming();
+
+        build_nodes(layer, entities, edges);
+
+        state.PauseTiming();
+        byte_count = allocated_byte_count.load(std::memory_order_relaxed) - allocated_before;
+        state.ResumeTiming();
+    }
+    state.counters["bytes_per_node"] = static_cast<double>(byte_count) / static_cast<double>(entity_count);
+}
+
+void BM_flat_tree_memory(benchmark::State& state) {
+    const auto entity_count = static_cast<std::size_t>(state.range(0));
+    const auto edges = depth_first_edges(entity_count);
+    std::size_t byte_count = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ecs::layer layer{};
+        const std::vector<entt::entity> entities = create_entities(layer, entity_count);
+        const std::size_t allocated_before = allocated_byte_count.load(std::memory_order_relaxed);
+        state.ResumeTiming();
+
+        flat_tree tree{ entities.front() };
+        build_flat_tree(tree, entities, edges);
+
+        state.PauseTiming();
+        byte_count = allocated_byte_count.load(std::memory_order_relaxed) - allocated_before;
+        state.ResumeTiming();
+    }
+    state.counters["bytes_per_node"] = static_cast<double>(byte_count) / static_cast<double>(entity_count);
+}
+
+template <tree_update_order order>
+void BM_node_traversal(benchmark::State& state) {
+    ecs::layer layer{};
+    const auto entity_count = static_cast<std::size_t>(state.range(0));
+    const std::vector<entt::entity> entities = create_entities(layer, entity_count);
+    const auto edges = depth_first_edges(entity_count);
+    build_nodes(layer, entities, edges);
+    const time_point a_time_point = time{}.calculate();
+
+    std::size_t visit_count = 0;
+    for (auto _ : state) {
+        tree_update_system(
+            order,
+            layer,
+            std::span{ &entities.front(), 1 },
+            [&visit_count](ecs::layer&, entt::entity entity, time_point) {
+                benchmark::DoNotOptimize(entity);
+                ++visit_count;
+            },
+            a_time_point
+        );
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(visit_count));
+}
+
+template <tree_update_order order>
+void BM_flat_tree_traversal(benchmark::State& state) {
+    ecs::layer layer{};
+    const auto entity_count = static_cast<std::size_t>(state.range(0));
+    const std::vector<entt::entity> entities = create_entities(layer, entity_count);
+    const auto edges = depth_first_edges(entity_count);
+    flat_tree tree{ entities.front() };
+    build_flat_tree(tree, entities, edges);
+    const time_point a_time_point = time{}.calculate();
+
+    std::size_t visit_count = 0;
+    for (auto _ : state) {
+        tree_update_system(
+            order,
+            layer,
+            tree,
+            [&visit_count](ecs::layer&, entt::entity entity, entt::entity parent, time_point) {
+                benchmark::DoNotOptimize(entity);
+                benchmark::DoNotOptimize(parent);
+                ++visit_count;
+            },
+            a_time_point
+        );
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(visit_count));
+}
+
+BENCHMARK(BM_node_memory)->Arg(10'000)->Arg(200'000)->Iterations(1);
+BENCHMARK(BM_flat_tree_memory)->Arg(10'000)->Arg(200'000)->Iterations(1);
+BENCHMARK(BM_node_traversal<tree_update_order::TOP_DOWN>)->Arg(10'000)->Arg(200'000);
+BENCHMARK(BM_flat_tree_traversal<tree_update_order::TOP_DOWN>)->Arg(10'000)->Arg(200'000);
+BENCHMARK(BM_node_traversal<tree_update_order::BOTTOM_UP>)->Arg(10'000)->Arg(200'000);
+BENCHMARK(BM_flat_tree_traversal<tree_update_order::BOTTOM_UP>)->Arg(10'000)->Arg(200'000);
+
+} // namespace
+} // namespace sl::game
+
+// counts every allocation of the benchmark executable, the counter is only read around building a hierarchy
+void* operator new(std::size_t byte_count) {
+    sl::game::allocated_byte_count.fetch_add(byte_count, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(byte_count == 0 ? 1 : byte_count); ptr != nullptr) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
@@ -252,6 +252,7 @@ exec::async<entt::entity>
                     game::transform tf = local_transform.get().value();
                     if (ImGui::SliderFloat3("light pos", glm::value_ptr(tf.tr), -10.0f, 10.0f)) {
                         local_transform.set(tf);
+                        layer.registry.patch<game::local_transform>(entity);
                     }
                 }
                 ImGui::ColorEdit3("light color", glm::value_ptr(state.color));
@@ -306,6 +307,7 @@ exec::async<std::vector<entt::entity>>
                     .tr = local_tf.get()->tr,
                     .rot = glm::angleAxis(glm::radians(angle), world.up()),
                 });
+                layer.registry.patch<game::local_transform>(entity);
             }
         );
 
@@ -403,6 +403,7 @@ exec::async<entt::entity>
             game::transform tf = local_transform.get().value();
             if (ImGui::SliderFloat3("light position", glm::value_ptr(tf.tr), -10.0f, 10.0f)) {
                 local_transform.set(tf);
+                layer.registry.patch<game::local_transform>(entity);
             }
         }
         ImGui::ColorEdit3("light ambient", glm::value_ptr(state.ambient));
@@ -513,6 +514,7 @@ exec::async<std::vector<entt::entity>>
                     .tr = local_tf.get()->tr,
                     .rot = glm::angleAxis(glm::radians(angle), world.up()),
                 });
+                layer.registry.patch<game::local_transform>(entity);
             }
         );
         layer.registry.emplace<game::overlay>(entity, [](ecs::layer& layer, gfx::imgui_frame&, entt::entity entity) {
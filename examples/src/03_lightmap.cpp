@@ -140,7 +140,7 @@ exec::async<game::shader> create_object_shader(const script::example_context& ex
                     set_light_diffuse = std::move(set_light_diffuse),
                     set_light_specular = std::move(set_light_specular),
                     set_material_shininess = std::move(set_material_shininess)](
-                    const ecs::layer& layer,
+                    ecs::layer& layer,
                     const game::camera_frame& camera_frame,
                     const gfx::bound_shader_program& bound_sp
                 ) mutable {
@@ -158,6 +158,7 @@ exec::async<game::shader> create_object_shader(const script::example_context& ex
                 set_light_specular(bound_sp, source_state.specular);
             }
 
+            auto& materials = game::material_binder::of(layer);
             return [&](const gfx::bound_vertex_array& bound_va,
                        game::vertex::draw_type& vertex_draw,
                        std::span<const entt::entity> entities) {
@@ -180,9 +181,10 @@ exec::async<game::shader> create_object_shader(const script::example_context& ex
                     set_it_model(bound_sp, it_model);
                     set_transform(bound_sp, transform);
 
-                    const auto bound_diffuse = mat.diffuse->tex.activate(0);
-                    const auto bound_specular = mat.specular->tex.activate(1);
-                    const auto bound_emission = mat.emission->tex.activate(2);
+                    // textures stay bound until the end of the frame, so that entities sharing them skip binds
+                    materials.bind_texture(0, mat.diffuse);
+                    materials.bind_texture(1, mat.specular);
+                    materials.bind_texture(2, mat.emission);
                     set_material_shininess(bound_sp, mat.shininess);
 
                     gfx::draw draw{ bound_sp, bound_va };
@@ -415,6 +417,7 @@ exec::async<entt::entity>
             game::transform tf = local_transform.get().value();
             if (ImGui::SliderFloat3("light position", glm::value_ptr(tf.tr), -10.0f, 10.0f)) {
                 local_transform.set(tf);
+                layer.registry.patch<game::local_transform>(entity);
             }
         }
         ImGui::ColorEdit3("light ambient", glm::value_ptr(state.ambient));
@@ -533,6 +536,7 @@ exec::async<std::vector<entt::entity>>
                     .tr = local_tf.get()->tr,
                     .rot = glm::angleAxis(glm::radians(angle), world.up()),
                 });
+                layer.registry.patch<game::local_transform>(entity);
             }
         );
         layer.registry.emplace<game::overlay>(entity, [](ecs::layer& layer, gfx::imgui_frame&, entt::entity entity) {
@@ -572,15 +576,15 @@ exec::async<void> create_scene(
     );
     ASSERT(co_await texture_resource.require(
         "texture.diffuse"_us(example_ctx.uss),
-        script::create_texture(example_ctx.examples_path / "textures/03_lightmap_diffuse.png")
+        script::create_texture(e_ctx, example_ctx.examples_path / "textures/03_lightmap_diffuse.png")
     ));
     ASSERT(co_await texture_resource.require(
         "texture.specular"_us(example_ctx.uss),
-        script::create_texture(example_ctx.examples_path / "textures/03_lightmap_specular.png")
+        script::create_texture(e_ctx, example_ctx.examples_path / "textures/03_lightmap_specular.png")
     ));
     ASSERT(co_await texture_resource.require(
         "texture.emission"_us(example_ctx.uss),
-        script::create_texture(example_ctx.examples_path / "textures/03_lightmap_emission.jpg")
+        script::create_texture(e_ctx, example_ctx.examples_path / "textures/03_lightmap_emission.jpg")
     ));
     // common ^^^
 
@@ -7,6 +7,8 @@
 #include <sl/exec/algo/make/result.hpp>
 #include <fmt/ranges.h>
 
+#include <unordered_map>
+
 namespace sl {
 
 struct global_entity_state {
@@ -99,20 +101,28 @@ exec::async<game::shader> create_object_shader(const script::example_context& ex
     auto sp = *ASSERT_VAL(gfx::shader_program::build(std::span{ shaders }));
     auto sp_bind = sp.bind();
 
-    constexpr std::array<std::string_view, 2> material_textures{
-        "u_material.diffuse",
-        "u_material.specular",
+    constexpr std::array<std::string_view, 2 + game::texture_arrays::max_array_count> material_textures{
+        "u_material.diffuse",   "u_material.specular",  "u_material_arrays[0]",
+        "u_material_arrays[1]", "u_material_arrays[2]", "u_material_arrays[3]",
     };
     sp_bind.initialize_tex_units(std::span{ material_textures });
+    constexpr std::uint32_t material_arrays_unit = 2;
 
     auto set_view_pos = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform3f, "u_view_pos"));
 
-    auto dl_buffer = game::make_and_initialize_ssbo<game::render::directional_light_element>(1);
-    auto pl_buffer = game::make_and_initialize_ssbo<game::render::point_light_element>(16);
-    auto sl_buffer = game::make_and_initialize_ssbo<game::render::spot_light_element>(1);
+    auto lights = std::make_unique<game::render::clustered_lights>();
     auto set_dl_size = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform1ui, "u_directional_light_size"));
     auto set_pl_size = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform1ui, "u_point_light_size"));
     auto set_sl_size = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform1ui, "u_spot_light_size"));
+    auto set_cluster_grid = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform3ui, "u_cluster_grid"));
+    auto set_cluster_near = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform1f, "u_cluster_near"));
+    auto set_cluster_depth_scale = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform1f, "u_cluster_depth_scale"));
+
+    // instanced and per entity draws of one program interleave, so both of them set u_instanced
+    auto set_instanced = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform1i, "u_instanced"));
+    auto set_not_instanced = *ASSERT_VAL(sp_bind.make_uniform_setter(glUniform1i, "u_instanced"));
+    auto set_view_projection =
+        *ASSERT_VAL(sp_bind.make_uniform_matrix_v_setter(glUniformMatrix4fv, "u_view_projection", 1, false));
 
     auto set_material_diffuse_color =
         *ASSERT_VAL(sp_bind.make_uniform_v_setter(glUniform4fv, "u_material.diffuse_color", 1));
@@ -127,16 +137,9 @@ exec::async<game::shader> create_object_shader(const script::example_context& ex
 
     co_return game::shader{
         .sp{ std::move(sp) },
+        // lights and bindings of setup_instanced are used by these draws too, since it is called first
         .setup{ [ //
-                    world,
-                    set_view_pos = std::move(set_view_pos),
-
-                    dl_buffer = std::move(dl_buffer),
-                    pl_buffer = std::move(pl_buffer),
-                    sl_buffer = std::move(sl_buffer),
-                    set_dl_size = std::move(set_dl_size),
-                    set_pl_size = std::move(set_pl_size),
-                    set_sl_size = std::move(set_sl_size),
+                    set_not_instanced = std::move(set_not_instanced),
 
                     set_material_diffuse_color = std::move(set_material_diffuse_color),
                     set_material_specular_color = std::move(set_material_specular_color),
@@ -146,51 +149,35 @@ exec::async<game::shader> create_object_shader(const script::example_context& ex
                     set_model = std::move(set_model),
                     set_it_model = std::move(set_it_model),
                     set_transform = std::move(set_transform)](
-                    const ecs::layer& layer,
+                    ecs::layer& layer,
                     const game::camera_frame& camera_frame,
                     const gfx::bound_shader_program& bound_sp
                 ) mutable {
-            set_view_pos(bound_sp, camera_frame.position);
-
-            const std::uint32_t dl_size = game::fill_ssbo(layer, world, dl_buffer);
-            set_dl_size(bound_sp, dl_size);
-
-            const std::uint32_t pl_size = game::fill_ssbo(layer, world, pl_buffer);
-            set_pl_size(bound_sp, pl_size);
-
-            const std::uint32_t sl_size = game::fill_ssbo(layer, world, sl_buffer);
-            set_sl_size(bound_sp, sl_size);
-
             auto* const maybe_mat_resource =
                 layer.registry.try_get<ecs::resource<game::material>::ptr_type>(layer.root);
+            auto& materials = game::material_binder::of(layer);
 
-            return [&,
-                    maybe_mat_resource,
-                    bound_dl_base = dl_buffer.bind_base(0),
-                    bound_pl_base = pl_buffer.bind_base(1),
-                    bound_sl_base = sl_buffer.bind_base(2)]( //
+            return [&, maybe_mat_resource]( //
                        const gfx::bound_vertex_array& bound_va,
                        game::vertex::draw_type& vertex_draw,
                        std::span<const entt::entity> entities
                    ) {
+                set_not_instanced(bound_sp, GL_FALSE);
                 for (const entt::entity entity : entities) {
-                    const auto [maybe_tf, maybe_mat_id] =
-                        layer.registry.try_get<game::transform, game::material::id>(entity);
-                    if (!maybe_tf || !maybe_mat_id) {
-                        game::log::warn("entity={} missing transform or material", static_cast<std::uint32_t>(entity));
+                    const auto [maybe_world_matrix, maybe_mat_id] =
+                        layer.registry.try_get<game::world_matrix, game::material::id>(entity);
+                    if (!maybe_world_matrix || !maybe_mat_id) {
+                        game::log::warn(
+                            "entity={} missing world_matrix or material", static_cast<std::uint32_t>(entity)
+                        );
                         continue;
                     }
-                    const auto& tf = *maybe_tf;
-                    const auto& mat_id = *maybe_mat_id;
-
-                    const glm::mat4 translation_matrix = glm::translate(glm::mat4(1.0f), tf.tr);
-                    const glm::mat4 rotation_matrix = glm::mat4_cast(tf.rot);
-                    // TODO: scale
-                    const glm::mat4 model = translation_matrix * rotation_matrix;
-                    const glm::mat3 it_model = glm::transpose(glm::inverse(model));
-                    const glm::mat4 transform = camera_frame.projection * camera_frame.view * model;
-                    set_model(bound_sp, model);
-                    set_it_model(bound_sp, it_model);
+                    const auto& world_matrix = *maybe_world_matrix;
+                    auto& mat_id = *maybe_mat_id;
+
+                    const glm::mat4 transform = camera_frame.projection * camera_frame.view * world_matrix.model;
+                    set_model(bound_sp, world_matrix.model);
+                    set_it_model(bound_sp, world_matrix.normal);
                     set_transform(bound_sp, transform);
 
                     if (maybe_mat_resource == nullptr) [[unlikely]] {
@@ -198,45 +185,101 @@ exec::async<game::shader> create_object_shader(const script::example_context& ex
                     }
                     auto& mat_resource = **maybe_mat_resource;
 
-                    const auto maybe_mat = mat_resource.lookup_unsafe(mat_id.id);
-                    if (!maybe_mat.has_value()) [[unlikely]] {
-                        continue;
+                    // entities come ordered by material, so most of them reuse uniforms and textures of the previous
+                    if (materials.apply(materials.handle_of(mat_id.id))) {
+                        const auto maybe_mat = mat_resource.lookup_unsafe(mat_id.id, mat_id.handle);
+                        if (!maybe_mat.has_value()) [[unlikely]] {
+                            materials.invalidate();
+                            continue;
+                        }
+                        const auto& mat = maybe_mat.value();
+
+                        const bool is_diffuse_tex =
+                            mat->diffuse
+                            | meta::pmatch{
+                                  [&](const ecs::resource_reference<game::texture>& tex) {
+                                      materials.bind_texture(0, tex);
+                                      return true;
+                                  },
+                                  [&](const glm::vec4& clr) {
+                                      set_material_diffuse_color(bound_sp, clr);
+                                      return false;
+                                  },
+                              };
+                        const bool is_specular_tex =
+                            mat->specular
+                            | meta::pmatch{
+                                  [&](const ecs::resource_reference<game::texture>& tex) {
+                                      materials.bind_texture(1, tex);
+                                      return true;
+                                  },
+                                  [&](const glm::vec4& clr) {
+                                      set_material_specular_color(bound_sp, clr);
+                                      return false;
+                                  },
+                              };
+
+                        const std::uint32_t mat_mode = (is_diffuse_tex ? 0b01 : 0) + (is_specular_tex ? 0b10 : 0);
+                        set_material_mode(bound_sp, mat_mode);
+                        set_material_shininess(bound_sp, mat->shininess);
                     }
-                    const auto& mat = maybe_mat.value();
-
-                    const auto maybe_bound_diffuse_tex =
-                        mat->diffuse
-                        | meta::pmatch{
-                              [](const meta::persistent<game::texture>& tex) -> meta::maybe<gfx::bound_texture> {
-                                  return tex->tex.activate(0);
-                              },
-                              [&](const glm::vec4& clr) -> meta::maybe<gfx::bound_texture> {
-                                  set_material_diffuse_color(bound_sp, clr);
-                                  return meta::null;
-                              },
-                          };
-                    const auto maybe_bound_specular_tex =
-                        mat->specular
-                        | meta::pmatch{
-                              [](const meta::persistent<game::texture>& tex) -> meta::maybe<gfx::bound_texture> {
-                                  return tex->tex.activate(1);
-                              },
-                              [&](const glm::vec4& clr) -> meta::maybe<gfx::bound_texture> {
-                                  set_material_specular_color(bound_sp, clr);
-                                  return meta::null;
-                              },
-                          };
-
-                    const std::uint32_t mat_mode = (maybe_bound_diffuse_tex.has_value() ? 0b01 : 0)
-                                                   + (maybe_bound_specular_tex.has_value() ? 0b10 : 0);
-                    set_material_mode(bound_sp, mat_mode);
-                    set_material_shininess(bound_sp, mat->shininess);
 
                     gfx::draw draw{ bound_sp, bound_va };
                     vertex_draw(draw);
                 }
             };
         } },
+        // whole (shader, vertex) batches with mixed materials are drawn at once, see game::material_table
+        .setup_instanced{ [ //
+                              world,
+                              set_view_pos = std::move(set_view_pos),
+
+                              lights = std::move(lights),
+                              set_dl_size = std::move(set_dl_size),
+                              set_pl_size = std::move(set_pl_size),
+                              set_sl_size = std::move(set_sl_size),
+                              set_cluster_grid = std::move(set_cluster_grid),
+                              set_cluster_near = std::move(set_cluster_near),
+                              set_cluster_depth_scale = std::move(set_cluster_depth_scale),
+
+                              set_instanced = std::move(set_instanced),
+                              set_view_projection = std::move(set_view_projection)](
+                              ecs::layer& layer,
+                              const game::camera_frame& camera_frame,
+                              const gfx::bound_shader_program& bound_sp
+                          ) mutable {
+            set_view_pos(bound_sp, camera_frame.position);
+            set_view_projection(bound_sp, camera_frame.projection * camera_frame.view);
+
+            auto& dl_mirror = game::ssbo_mirror<game::render::directional_light_element>::of(layer);
+            dl_mirror.update(world);
+            set_dl_size(bound_sp, dl_mirror.size());
+
+            lights->upload(layer, world, camera_frame, nullptr);
+            set_pl_size(bound_sp, static_cast<std::uint32_t>(lights->points().size()));
+            set_sl_size(bound_sp, static_cast<std::uint32_t>(lights->spots().size()));
+            const auto cluster_parameters = lights->parameters();
+            set_cluster_grid(bound_sp, cluster_parameters.grid);
+            set_cluster_near(bound_sp, cluster_parameters.near);
+            set_cluster_depth_scale(bound_sp, cluster_parameters.depth_scale);
+
+            // material_table is updated by graphics_system before instances are uploaded
+            game::texture_arrays::of(layer).bind(material_arrays_unit);
+            auto& material_table = game::material_table::of(layer);
+
+            return [&,
+                    bound_dl_base = dl_mirror.bind_base(0),
+                    bound_light_bases = lights->bind_bases(),
+                    bound_materials_base = material_table.bind_base()]( //
+                       const gfx::bound_vertex_array& bound_va,
+                       game::vertex::draw_instanced_type& vertex_draw_instanced,
+                       game::instance_range range
+                   ) {
+                set_instanced(bound_sp, GL_TRUE);
+                gfx::draw draw{ bound_sp, bound_va };
+                vertex_draw_instanced(draw, range.base, range.count);
+            };
+        } },
     };
 }
 
@@ -415,6 +458,8 @@ exec::async<entt::entity>
                 }();
                 tf.translate(speed * (tf.rot * new_tr));
             }
+            // modified in place, let observers such as ssbo_mirror know
+            layer.registry.patch<game::transform>(entity);
 
             state.rmb.get().map([&cw = e_ctx.w_ctx.current_window](bool rmb) {
                 cw.set_input_mode(GLFW_CURSOR, rmb ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
@@ -436,6 +481,27 @@ exec::async<entt::entity>
             .outer_cutoff = glm::cos(glm::radians(15.0f)),
         }
     );
+    layer.registry.emplace<game::overlay>(
+        entity,
+        [&world](ecs::layer& layer, gfx::imgui_frame&, entt::entity entity) {
+            auto* const maybe_spatial_index = layer.registry.try_get<game::spatial_index::ptr_type>(layer.root);
+            const auto* const maybe_tf = layer.registry.try_get<game::transform>(entity);
+            if (maybe_spatial_index == nullptr || maybe_tf == nullptr) {
+                return;
+            }
+            // picking, boxes are of the previous frame
+            const auto hits = (*maybe_spatial_index)->query(game::ray{
+                .origin = maybe_tf->tr,
+                .direction = maybe_tf->rot * world.forward(),
+            });
+            ImGui::Spacing();
+            if (hits.empty()) {
+                ImGui::Text("looking at nothing");
+            } else {
+                ImGui::Text("looking at entity %u", static_cast<unsigned>(entt::to_integral(hits.front())));
+            }
+        }
+    );
 
     co_return entity;
 }
@@ -508,6 +574,7 @@ exec::async<std::vector<entt::entity>>
                     current.ambient = initial.ambient * coef;
                     current.diffuse = initial.diffuse * coef;
                     current.specular = initial.specular * coef;
+                    layer.registry.patch<game::render::point_light>(pl_entity);
                 }
             }
         }(e_ctx, layer, entities)
@@ -535,13 +602,18 @@ exec::async<std::vector<entt::entity>>
                     auto transform = maybe_transform.value();
                     transform.rot = glm::quat{ eulerAngles };
                     local_transform.set(std::move(transform));
+                    layer.registry.patch<game::local_transform>(entity);
                 }
             }
 
             auto& directional_light = layer.registry.get<game::render::directional_light>(entity);
-            ImGui::ColorEdit3("directional_light ambient", glm::value_ptr(directional_light.ambient));
-            ImGui::ColorEdit3("directional_light diffuse", glm::value_ptr(directional_light.diffuse));
-            ImGui::ColorEdit3("directional_light specular", glm::value_ptr(directional_light.specular));
+            bool is_changed = false;
+            is_changed |= ImGui::ColorEdit3("directional_light ambient", glm::value_ptr(directional_light.ambient));
+            is_changed |= ImGui::ColorEdit3("directional_light diffuse", glm::value_ptr(directional_light.diffuse));
+            is_changed |= ImGui::ColorEdit3("directional_light specular", glm::value_ptr(directional_light.specular));
+            if (is_changed) {
+                layer.registry.patch<game::render::directional_light>(entity);
+            }
         });
 
         entities.push_back(entity);
@@ -613,6 +685,7 @@ exec::async<std::vector<entt::entity>>
     };
     constexpr std::size_t rows = 5;
     constexpr std::size_t cols = 5;
+    constexpr game::aabb cube_bounds{ .min{ -0.5f }, .max{ 0.5f } };
 
     std::vector<entt::entity> entities;
     entities.reserve(rows * cols + 1);
@@ -624,6 +697,7 @@ exec::async<std::vector<entt::entity>>
         layer.registry.emplace<game::shader::id>(entity, object_shader_id);
         layer.registry.emplace<game::vertex::id>(entity, cube_vertex_id);
         layer.registry.emplace<game::material::id>(entity, crate_material_id);
+        layer.registry.emplace<game::aabb>(entity, cube_bounds);
 
         const float angle0 = 20.0f * (static_cast<float>(index));
         layer.registry.emplace<game::local_transform>(
@@ -633,6 +707,7 @@ exec::async<std::vector<entt::entity>>
                 .rot = glm::angleAxis(0.0f, world.up()),
             }
         );
+        layer.registry.emplace<game::world_matrix>(entity);
         layer.registry.emplace<game::update>(
             entity,
             [&world, angle0](ecs::layer& layer, entt::entity entity, game::time_point tp) {
@@ -644,6 +719,7 @@ exec::async<std::vector<entt::entity>>
                     .tr = local_tf.get()->tr,
                     .rot = glm::angleAxis(glm::radians(angle), world.up()),
                 });
+                layer.registry.patch<game::local_transform>(entity);
             }
         );
 
@@ -656,7 +732,9 @@ exec::async<std::vector<entt::entity>>
         layer.registry.emplace<game::shader::id>(entity, object_shader_id);
         layer.registry.emplace<game::vertex::id>(entity, cube_vertex_id);
         layer.registry.emplace<game::material::id>(entity, solid_material_id);
+        layer.registry.emplace<game::aabb>(entity, cube_bounds);
         layer.registry.emplace<game::local_transform>(entity, game::transform{ .tr{ 0.0f, 2.0f, 0.0f } });
+        layer.registry.emplace<game::world_matrix>(entity);
 
         entities.push_back(entity);
     }
@@ -666,10 +744,13 @@ exec::async<std::vector<entt::entity>>
 }
 
 exec::async<entt::entity> create_imported_entity(
+    const game::engine_context& e_ctx,
     script::example_context& example_ctx,
     ecs::layer& layer,
     const std::filesystem::path& asset_relpath
 ) {
+    using exec::operator co_await;
+
     const auto object_shader_id = "shader.object"_us(example_ctx.uss);
     const auto crate_material_id = "material.crate"_us(example_ctx.uss);
     const auto default_material_id = crate_material_id;
@@ -686,34 +767,55 @@ exec::async<entt::entity> create_imported_entity(
     const auto asset_path = example_ctx.asset_path / asset_relpath;
     const auto asset_id = asset_relpath.generic_string();
     const auto asset_directory = asset_path.parent_path();
+    // parser is thread_local, so that it can be used by any thread of load_exec
+    co_await e_ctx.to_load_exec();
     const auto asset = [&] {
         auto data_buffer = *ASSERT_VAL(GltfDataBuffer::FromPath(asset_path));
         auto asset = *ASSERT_VAL(parser.loadGltf(data_buffer, asset_directory));
         return asset;
     }();
+    // resources and geometry pools are accessed on the GL thread only
+    co_await e_ctx.to_gl_exec();
+
+    // textures of all materials are required at once, so that they are decoded concurrently
+    std::vector<meta::unique_string> texture_ids;
+    std::unordered_map<meta::unique_string, std::filesystem::path> texture_paths;
+    std::vector<meta::maybe<meta::unique_string>> material_texture_ids;
+    for (const auto& material : asset.materials) {
+        const auto& material_texture = material.pbrData.baseColorTexture;
+        if (!material_texture.has_value()) {
+            material_texture_ids.emplace_back();
+            continue;
+        }
+
+        const auto& texture = asset.textures.at(material_texture->textureIndex);
+        const auto& image = asset.images.at(*ASSERT_VAL(texture.imageIndex));
+        const auto& image_uri = *ASSERT_VAL(std::get_if<sources::URI>(&image.data));
+        const auto texture_id = "{}.texture"_ufs(image_uri.uri.string())(example_ctx.uss);
+        game::log::debug("texture_id={}", texture_id);
+        if (texture_paths.try_emplace(texture_id, asset_directory / image_uri.uri.fspath()).second) {
+            texture_ids.push_back(texture_id);
+        }
+        material_texture_ids.emplace_back(texture_id);
+    }
+    const auto textures = co_await texture_resource.require_many(
+        std::span<const meta::unique_string>{ texture_ids },
+        [&](meta::unique_string texture_id) {
+            return script::create_texture(e_ctx, texture_paths.at(texture_id), false, &game::texture_arrays::of(layer));
+        }
+    );
 
     for (const auto& [material_i, material] : ranges::views::enumerate(asset.materials)) {
         const auto& material_pbr = material.pbrData;
-        const auto& material_texture = material_pbr.baseColorTexture;
-
         const auto material_id = "{}.material[{}]"_ufs(asset_id, material_i)(example_ctx.uss);
-        auto diffuse = co_await [&]() -> exec::async<game::texture_or_color> {
-            if (!material_texture.has_value()) {
-                const auto color = std::bit_cast<glm::vec4>(material_pbr.baseColorFactor);
-                game::log::debug("color={}", glm::to_string(color));
-                co_return color;
-            }
 
-            const auto& texture = asset.textures.at(material_texture->textureIndex);
-            const auto& image = asset.images.at(*ASSERT_VAL(texture.imageIndex));
-            const auto& image_uri = *ASSERT_VAL(std::get_if<sources::URI>(&image.data));
-            const auto texture_path = asset_directory / image_uri.uri.fspath();
-            const auto texture_id = "{}.texture"_ufs(image_uri.uri.string())(example_ctx.uss);
-            game::log::debug("texture_id={}", texture_id);
-            co_return *ASSERT_VAL(
-                co_await texture_resource.require(texture_id, script::create_texture(texture_path, false))
-            );
-        }();
+        game::texture_or_color diffuse = std::bit_cast<glm::vec4>(material_pbr.baseColorFactor);
+        if (const auto& maybe_texture_id = material_texture_ids[material_i]; maybe_texture_id.has_value()) {
+            const auto texture_it = std::ranges::find(texture_ids, maybe_texture_id.value());
+            diffuse = *ASSERT_VAL(textures[static_cast<std::size_t>(texture_it - texture_ids.begin())]);
+        } else {
+            game::log::debug("color={}", glm::to_string(std::get<glm::vec4>(diffuse)));
+        }
 
         ASSERT(co_await material_resource.require(
             material_id,
@@ -850,7 +952,8 @@ exec::async<entt::entity> create_imported_entity(
                 const auto f = [&](const auto indices_data) -> exec::async<void> {
                     const std::span indices_span = indices_data.subspan(0, indices_accessor.count);
                     ASSERT(co_await vertex_resource.require(
-                        primitive_vertex_id, script::create_vertex(std::span(vnts), indices_span)
+                        primitive_vertex_id,
+                        script::create_pooled_vertex(game::geometry_pool<VNT>::of(layer), std::span(vnts), indices_span)
                     ));
                 };
 
@@ -929,6 +1032,7 @@ exec::async<entt::entity> create_imported_entity(
                 layer.registry.emplace<game::vertex::id>(primitive_entity, primitive_asset->vtx);
                 layer.registry.emplace<game::material::id>(primitive_entity, primitive_asset->mtl);
                 layer.registry.emplace<game::local_transform>(primitive_entity, game::transform{});
+                layer.registry.emplace<game::world_matrix>(primitive_entity);
                 game::node::attach_child(layer, node_entity, primitive_entity);
             }
             game::log::debug("node_entity={} attached mesh={}", static_cast<entt::id_type>(node_entity), mesh_id);
@@ -991,11 +1095,21 @@ exec::async<void> create_scene(game::engine_context& e_ctx, ecs::layer& layer, c
         ASSERT(co_await shader_resource.require("shader.unlit"_us(example_ctx.uss), create_unlit_shader(example_ctx)));
         auto texture_diffuse = *ASSERT_VAL(co_await texture_resource.require(
             "texture.diffuse"_us(example_ctx.uss),
-            script::create_texture(example_ctx.examples_path / "textures/03_lightmap_diffuse.png")
+            script::create_texture(
+                e_ctx,
+                example_ctx.examples_path / "textures/03_lightmap_diffuse.png",
+                true,
+                &game::texture_arrays::of(layer)
+            )
         ));
         auto texture_specular = *ASSERT_VAL(co_await texture_resource.require(
             "texture.specular"_us(example_ctx.uss),
-            script::create_texture(example_ctx.examples_path / "textures/03_lightmap_specular.png")
+            script::create_texture(
+                e_ctx,
+                example_ctx.examples_path / "textures/03_lightmap_specular.png",
+                true,
+                &game::texture_arrays::of(layer)
+            )
         ));
         ASSERT(co_await material_resource.require(
             "material.crate"_us(example_ctx.uss),
@@ -1013,6 +1127,10 @@ exec::async<void> create_scene(game::engine_context& e_ctx, ecs::layer& layer, c
                 .shininess = 128.0f * 0.6f,
             })
         ));
+        // created before entities with materials, so that the first frame already draws them instanced
+        game::material_table::of(layer);
+        // updated by engine_context after transforms, entities with aabb are indexed
+        layer.registry.emplace<game::spatial_index::ptr_type>(layer.root, game::spatial_index::make(layer.registry));
     }
     // common ^^^
 
@@ -1026,7 +1144,7 @@ exec::async<void> create_scene(game::engine_context& e_ctx, ecs::layer& layer, c
     const auto cube_entities = co_await create_cube_entities(example_ctx, layer, world);
     game::node::attach_children(layer, global_entity, std::span{ cube_entities });
 
-    const entt::entity imported_entity = co_await create_imported_entity(example_ctx, layer, "meshes/cube.gltf");
+    const entt::entity imported_entity = co_await create_imported_entity(e_ctx, example_ctx, layer, "meshes/cube.gltf");
     game::node::attach_child(layer, global_entity, imported_entity);
 }
 
@@ -1042,7 +1160,7 @@ void main(int argc, char** argv) {
     );
     auto e_ctx = game::engine_context::initialize(std::move(w_ctx), argc, argv);
     ecs::layer layer{};
-    game::graphics_system gfx_system{ .layer = layer, .world{} };
+    game::graphics_system gfx_system{ .layer = layer, .world{}, .workers = e_ctx.workers.get() };
     game::overlay_system overlay_system{ .layer = layer };
 
     exec::coro_schedule(*e_ctx.script_exec, create_scene(e_ctx, layer, gfx_system.world));
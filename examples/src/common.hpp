@@ -12,6 +12,7 @@
 #include <sl/rt.hpp>
 
 #include <imgui.h>
+#include <bit>
 #include <stb/image.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -57,16 +58,40 @@ public:
     std::filesystem::path asset_path;
 };
 
-inline exec::async<game::texture> create_texture(const std::filesystem::path& image_path, bool flip_vertically = true) {
+// image is read and decoded on load_exec, so that frames do not stall on it,
+// arrays are optional, the image is also packed there if it fits
+inline exec::async<game::texture> create_texture(
+    const game::engine_context& e_ctx,
+    std::filesystem::path image_path,
+    bool flip_vertically = true,
+    game::texture_arrays* arrays = nullptr
+) {
+    using exec::operator co_await;
+
+    co_await e_ctx.to_load_exec();
+    const auto image = *ASSERT_VAL(stb::image_load(image_path, 4, flip_vertically));
+    co_await e_ctx.to_gl_exec();
+
     gfx::texture_builder tex_builder{ gfx::texture_type::texture_2d };
     tex_builder.set_wrap_s(gfx::texture_wrap::repeat);
     tex_builder.set_wrap_t(gfx::texture_wrap::repeat);
     tex_builder.set_min_filter(gfx::texture_filter::nearest);
     tex_builder.set_max_filter(gfx::texture_filter::nearest);
-
-    const auto image = *ASSERT_VAL(stb::image_load(image_path, 4, flip_vertically));
     tex_builder.set_image(std::span{ image.dimensions }, gfx::texture_format{ GL_RGB, GL_RGBA }, image.data.get());
-    co_return game::texture{ .tex = std::move(tex_builder).submit() };
+
+    meta::maybe<game::pooled_layer> layer;
+    if (arrays != nullptr) {
+        const glm::uvec2 size{ static_cast<std::uint32_t>(image.dimensions[0]),
+                               static_cast<std::uint32_t>(image.dimensions[1]) };
+        const std::span<const std::byte> rgba =
+            std::as_bytes(std::span{ image.data.get(), std::size_t{ size.x } * size.y * 4 });
+        layer = arrays->add(size, rgba);
+    }
+    co_return game::texture{
+        .tex = std::move(tex_builder).submit(),
+        .layer = std::move(layer),
+        .byte_size = static_cast<std::size_t>(image.dimensions[0]) * static_cast<std::size_t>(image.dimensions[1]) * 4,
+    };
 }
 
 template <typename VT, std::size_t vertices_extent, std::unsigned_integral indices_type, std::size_t indices_extent>
@@ -78,11 +103,57 @@ exec::async<game::vertex> create_vertex(
     va_builder.attributes_from<VT>();
     auto vb = va_builder.buffer<gfx::buffer_type::array, gfx::buffer_usage::static_draw>(vertices);
     auto eb = va_builder.buffer<gfx::buffer_type::element_array, gfx::buffer_usage::static_draw>(indices);
+    constexpr GLenum indices_gl_type = sizeof(indices_type) == sizeof(std::uint8_t)    ? GL_UNSIGNED_BYTE
+                                       : sizeof(indices_type) == sizeof(std::uint16_t) ? GL_UNSIGNED_SHORT
+                                                                                       : GL_UNSIGNED_INT;
     co_return game::vertex{
         .va = std::move(va_builder).submit(),
         .draw{ [vb = std::move(vb), eb = std::move(eb)](gfx::draw& draw) { draw.elements(eb); } },
+        // element buffer is owned by draw and stays bound to va
+        .draw_instanced{ [indices_count = static_cast<GLsizei>(indices.size())](
+                             gfx::draw&, std::uint32_t base_instance, std::uint32_t instance_count
+                         ) {
+            glDrawElementsInstancedBaseInstance(
+                GL_TRIANGLES,
+                indices_count,
+                indices_gl_type,
+                nullptr,
+                static_cast<GLsizei>(instance_count),
+                base_instance
+            );
+        } },
+        .bounds = game::aabb::from_points(
+            vertices,
+            [](const VT& vertex) {
+                static_assert(sizeof(vertex.vert) == sizeof(glm::vec3));
+                return std::bit_cast<glm::vec3>(vertex.vert);
+            }
+        ),
+        .byte_size = vertices.size_bytes() + indices.size_bytes(),
     };
 }
 
+// suballocated from pool, instanced batches of all vertices of the pool are drawn by a single multi draw
+template <typename VT, std::size_t vertices_extent, std::unsigned_integral indices_type, std::size_t indices_extent>
+exec::async<game::vertex> create_pooled_vertex(
+    game::geometry_pool<VT>& pool,
+    std::span<const VT, vertices_extent> vertices,
+    std::span<const indices_type, indices_extent> indices
+) {
+    game::vertex a_vertex = pool.vertex_of(
+        pool.add(std::span<const VT>{ vertices }, std::span<const indices_type>{ indices }),
+        game::aabb::from_points(
+            vertices,
+            [](const VT& vertex) {
+                static_assert(sizeof(vertex.vert) == sizeof(glm::vec3));
+                return std::bit_cast<glm::vec3>(vertex.vert);
+            }
+        )
+    );
+    // range returns to the pool once the vertex is evicted
+    a_vertex.byte_size = vertices.size() * sizeof(VT) + indices.size() * sizeof(game::geometry_pool_base::index_type);
+    co_return a_vertex;
+}
+
 } // namespace script
 } // namespace sl
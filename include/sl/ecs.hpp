@@ -6,4 +6,5 @@
 
 #include "sl/ecs/layer.hpp"
 #include "sl/ecs/resource.hpp"
+#include "sl/ecs/resource_handle.hpp"
 #include "sl/ecs/vendor.hpp"
@@ -6,10 +6,19 @@
 
 #include "sl/ecs/vendor.hpp"
 
+#include <sl/meta/traits/unique.hpp>
+
 namespace sl::ecs {
 
-struct layer {
+// Components of root are destroyed first, while the registry is still whole, since systems kept there
+// disconnect from registry signals in their destructors.
+struct layer : meta::unique {
     explicit layer() : registry{}, root{ registry.create() } {}
+    ~layer() {
+        if (registry.valid(root)) {
+            registry.destroy(root);
+        }
+    }
 
 public:
     entt::registry registry;
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include "sl/ecs/resource_handle.hpp"
 #include "sl/ecs/vendor.hpp"
 
+#include <sl/exec.hpp>
 #include <sl/exec/algo/emit/force.hpp>
 #include <sl/exec/algo/make/contract.hpp>
 #include <sl/exec/algo/sched/continue_on.hpp>
@@ -20,7 +22,126 @@
 #include <sl/meta/traits/is_specialization.hpp>
 #include <sl/meta/traits/unique.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 namespace sl::ecs {
+namespace detail {
+
+// Read-optimized copy of loaded references, split into shards by id hash, so that readers of different ids
+// do not contend on a lock, and readers of the same id only share it.
+// Written only by loaders, which are already exclusive through resource::mutex_.
+template <typename ReferenceT>
+class resource_index : meta::unique {
+public:
+    static constexpr std::size_t shard_count = 16;
+
+public:
+    [[nodiscard]] meta::maybe<ReferenceT> lookup(meta::unique_string id) const {
+        const shard& a_shard = shard_of(id);
+        std::shared_lock lock{ a_shard.mutex };
+        if (const auto it = a_shard.references.find(id); it != a_shard.references.end()) {
+            return it->second;
+        }
+        return meta::null;
+    }
+
+    void publish(meta::unique_string id, ReferenceT reference) {
+        shard& a_shard = shard_of(id);
+        std::unique_lock lock{ a_shard.mutex };
+        a_shard.references.insert_or_assign(id, std::move(reference));
+    }
+
+    void erase(meta::unique_string id) {
+        shard& a_shard = shard_of(id);
+        std::unique_lock lock{ a_shard.mutex };
+        a_shard.references.erase(id);
+    }
+
+private:
+    // own cache line, so that writers of one shard do not slow down readers of another
+    struct alignas(64) shard {
+        mutable std::shared_mutex mutex;
+        tsl::robin_map<meta::unique_string, ReferenceT> references;
+    };
+
+    [[nodiscard]] shard& shard_of(meta::unique_string id) {
+        return shards_[std::hash<meta::unique_string>{}(id) % shard_count];
+    }
+    [[nodiscard]] const shard& shard_of(meta::unique_string id) const {
+        return shards_[std::hash<meta::unique_string>{}(id) % shard_count];
+    }
+
+private:
+    std::array<shard, shard_count> shards_{};
+};
+
+// memory accounted for a loaded value, values may report what they own besides themselves through byte_size
+template <typename T>
+[[nodiscard]] std::size_t byte_size_of(const T& value) {
+    if constexpr (requires {
+                      { value.byte_size } -> std::convertible_to<std::size_t>;
+                  }) {
+        return sizeof(T) + value.byte_size;
+    } else {
+        return sizeof(T);
+    }
+}
+
+// Shared by the slot of a loaded value, its copy in resource_index and every resource_reference to it,
+// so that use_count tells whether the value is retained by anybody besides the resource.
+struct resource_entry {
+    std::atomic<std::uint64_t> last_use{ 0 };
+};
+
+} // namespace detail
+
+template <typename T>
+struct resource;
+
+// Reference to a loaded value, which is not evicted while any copy of it exists.
+// Converts to meta::persistent for uses that do not outlive the next load on the executor.
+template <typename T>
+class resource_reference {
+public:
+    resource_reference(meta::persistent<T> reference, std::shared_ptr<detail::resource_entry> entry)
+        : reference_{ std::move(reference) }, entry_{ std::move(entry) } {}
+
+    [[nodiscard]] T& operator*() const { return *reference_; }
+    [[nodiscard]] T* operator->() const { return &*reference_; }
+
+    [[nodiscard]] const meta::persistent<T>& persistent() const { return reference_; }
+    operator meta::persistent<T>() const { return reference_; }
+
+private:
+    friend struct resource<T>;
+
+    meta::persistent<T> reference_;
+    std::shared_ptr<detail::resource_entry> entry_;
+};
+
+// counters since creation of a resource, byte sizes are of own values, without the parent
+struct resource_stats {
+    std::size_t hit_count = 0; // require and request which found the value loaded
+    std::size_t miss_count = 0; // require and request which had to wait for a loader
+    std::size_t evict_count = 0;
+    std::size_t entry_count = 0;
+    std::size_t byte_size = 0;
+    std::size_t budget = 0;
+};
 
 template <typename T>
 struct resource : meta::unique {
@@ -35,14 +156,17 @@ public: // creation
                 .get_parent = [parent]() -> storage_type* { return parent == nullptr ? nullptr : &parent->storage_; },
             },
             executor,
+            parent,
         } };
     }
 
-    resource(typename storage_type::init_type storage_init, exec::executor& executor)
-        : storage_{ std::move(storage_init) }, mutex_{ executor } {}
+    resource(typename storage_type::init_type storage_init, exec::executor& executor, resource* parent = nullptr)
+        : storage_{ std::move(storage_init) }, executor_{ executor }, mutex_{ executor }, parent_{ parent } {}
 
 public: // behaviour
-    using reference_type = meta::persistent<T>;
+    using reference_type = resource_reference<T>;
+    // does not retain the value, valid until the next load on the executor
+    using unsafe_reference_type = meta::persistent<T>;
     using const_reference_type = meta::const_persistent<T>;
     using promise_type = exec::promise<reference_type, meta::unit>;
 
@@ -57,13 +181,20 @@ public: // behaviour
         require(meta::unique_string id, LoaderT loader, bool override_after_load = true) & {
         using exec::operator co_await;
 
+        if (auto maybe_value = lookup(id)) {
+            hit_count_.fetch_add(1, std::memory_order_relaxed);
+            co_return maybe_value.value();
+        }
+
         {
             exec::mutex_lock lock = (co_await mutex_.lock()).value();
 
-            if (auto maybe_value = storage_.lookup(id)) {
+            if (auto maybe_value = find_unsafe(id)) {
+                hit_count_.fetch_add(1, std::memory_order_relaxed);
                 co_await std::move(lock).unlock();
                 co_return maybe_value.value();
             }
+            miss_count_.fetch_add(1, std::memory_order_relaxed);
 
             const auto [promises_it, promises_is_emplaced] = promises_by_id_.try_emplace(id);
             if (!promises_is_emplaced) {
@@ -83,6 +214,269 @@ public: // behaviour
         }
 
         // loader context
+        co_return co_await load(id, std::move(loader), override_after_load);
+    }
+
+    // Same as require for every id, but the mutex is taken once for all of them.
+    // make_loader(id) is called for ids which are neither loaded nor being loaded, these loads are started
+    // concurrently on the executor. The caller is resumed once, after every id is resolved.
+    // Results are in the order of ids.
+    template <typename MakeLoaderT>
+    exec::async<std::vector<meta::maybe<reference_type>>> require_many(
+        std::span<const meta::unique_string> ids,
+        MakeLoaderT make_loader,
+        bool override_after_load = true
+    ) & {
+        using exec::operator co_await;
+
+        // shared with loads, the last completion may still touch it after the caller is resumed and returns
+        auto a_batch = std::make_shared<batch>(std::vector<meta::maybe<reference_type>>(ids.size()));
+        std::vector<std::size_t> unresolved_indices;
+        for (std::size_t index = 0; index < ids.size(); ++index) {
+            if (auto maybe_value = lookup(ids[index])) {
+                hit_count_.fetch_add(1, std::memory_order_relaxed);
+                a_batch->results[index] = std::move(maybe_value);
+            } else {
+                unresolved_indices.push_back(index);
+            }
+        }
+        if (unresolved_indices.empty()) {
+            co_return std::move(a_batch->results);
+        }
+
+        auto [done_future, done_promise] = exec::make_contract<meta::unit, meta::unit>();
+        a_batch->done.emplace(std::move(done_promise));
+        // released by the loop below, so that loads which complete meanwhile do not resume the caller early
+        a_batch->pending_count.store(unresolved_indices.size() + 1, std::memory_order_relaxed);
+
+        std::vector<exec::async<void>> loads;
+        {
+            exec::mutex_lock lock = (co_await mutex_.lock()).value();
+            for (const std::size_t index : unresolved_indices) {
+                const meta::unique_string id = ids[index];
+                if (auto maybe_value = find_unsafe(id)) {
+                    hit_count_.fetch_add(1, std::memory_order_relaxed);
+                    a_batch->results[index] = std::move(maybe_value);
+                    complete(*a_batch);
+                    continue;
+                }
+                miss_count_.fetch_add(1, std::memory_order_relaxed);
+
+                const auto [promises_it, promises_is_emplaced] = promises_by_id_.try_emplace(id);
+                if (!promises_is_emplaced) {
+                    // awaiter context, also for ids repeated in the batch
+                    auto [future, promise] = exec::make_contract<reference_type, meta::unit>();
+                    promises_it.value().push_back(std::move(promise));
+                    loads.push_back(await_into(std::move(future), a_batch, index));
+                    continue;
+                }
+                // loader context
+                loads.push_back(load_into(id, make_loader(id), override_after_load, a_batch, index));
+            }
+            co_await std::move(lock).unlock();
+        }
+
+        for (exec::async<void>& a_load : loads) {
+            exec::coro_schedule(executor_, std::move(a_load));
+        }
+        complete(*a_batch);
+
+        std::ignore = co_await std::move(done_future);
+        co_return std::move(a_batch->results);
+    }
+
+    // There can be only awaiter context.
+    // If storage does not contain id and there is not a loader present - meta::null is returned.
+    //
+    exec::async<meta::maybe<reference_type>> request(meta::unique_string id) & {
+        using exec::operator co_await;
+
+        if (auto maybe_value = lookup(id)) {
+            hit_count_.fetch_add(1, std::memory_order_relaxed);
+            co_return maybe_value.value();
+        }
+
+        exec::mutex_lock lock = (co_await mutex_.lock()).value();
+        if (auto maybe_value = find_unsafe(id)) {
+            hit_count_.fetch_add(1, std::memory_order_relaxed);
+            co_return maybe_value.value();
+        }
+
+        miss_count_.fetch_add(1, std::memory_order_relaxed);
+        const auto promises_it = promises_by_id_.find(id);
+        if (promises_it == promises_by_id_.end()) {
+            co_return meta::null;
+        }
+
+        auto [future, promise] = exec::make_contract<reference_type, meta::unit>();
+        promises_it.value().push_back(std::move(promise));
+        co_await std::move(lock).unlock();
+
+        auto result = co_await std::move(future);
+        if (result.has_value()) {
+            co_return std::move(result).value();
+        }
+        co_return meta::null;
+    }
+
+    // Safe to call from any thread while loaders run, finds values whose load has completed.
+    // Doesn't take the mutex, so it is the fast path of require and request as well.
+    [[nodiscard]] meta::maybe<reference_type> lookup(meta::unique_string id) & {
+        if (auto maybe_value = index_.lookup(id)) {
+            touch(*maybe_value.value().entry_);
+            return maybe_value;
+        }
+        if (parent_ == nullptr) {
+            return meta::null;
+        }
+        return parent_->lookup(id);
+    }
+
+    // only safe while no loader can insert concurrently, marks own values as used for eviction
+    [[nodiscard]] meta::maybe<unsafe_reference_type> lookup_unsafe(meta::unique_string id) & {
+        if (const auto it = slot_by_id_.find(id); it != slot_by_id_.end()) {
+            return use(slots_[it->second]);
+        }
+        return storage_.lookup(id);
+    }
+    [[nodiscard]] meta::maybe<const_reference_type> lookup_unsafe(meta::unique_string id) const& {
+        return storage_.lookup(id);
+    }
+
+    // Handle of an own loaded id, which makes lookups an array access.
+    // Stays valid when the value is overridden by a later load of the same id, becomes stale once it is evicted.
+    [[nodiscard]] meta::maybe<resource_handle> resolve_unsafe(meta::unique_string id) const& {
+        if (const auto it = slot_by_id_.find(id); it != slot_by_id_.end()) {
+            return resource_handle{ .index = it->second, .generation = slots_[it->second].generation };
+        }
+        return meta::null;
+    }
+
+    [[nodiscard]] meta::maybe<unsafe_reference_type> lookup_unsafe(resource_handle handle) & {
+        slot* const maybe_slot = slot_of(handle);
+        if (maybe_slot == nullptr) {
+            return meta::null;
+        }
+        return use(*maybe_slot);
+    }
+
+    // by handle, which is resolved from id if it is empty or stale, for ids that keep their handle between frames,
+    // values of the parent have no handles here and are looked up by id
+    [[nodiscard]] meta::maybe<unsafe_reference_type>
+        lookup_unsafe(meta::unique_string id, meta::maybe<resource_handle>& handle) & {
+        if (handle.has_value()) {
+            if (auto maybe_value = lookup_unsafe(handle.value())) {
+                return maybe_value;
+            }
+        }
+        handle = resolve_unsafe(id);
+        if (!handle.has_value()) {
+            return lookup_unsafe(id);
+        }
+        return lookup_unsafe(handle.value());
+    }
+
+public: // eviction
+    // byte_size_of all own values is kept under budget by evicting after loads, the default never evicts
+    void set_budget(std::size_t budget) & { budget_ = budget; }
+
+    // Evicts least recently used values, which no reference_type retains, until own values fit into the budget,
+    // returns the amount of evicted values.
+    // Only safe on the executor, references from lookup_unsafe do not retain values and may dangle after it.
+    std::size_t evict_unsafe() & {
+        if (byte_size_ <= budget_) {
+            return 0;
+        }
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> candidates; // last_use and slot
+        for (std::uint32_t index = 0; index < slots_.size(); ++index) {
+            const slot& a_slot = slots_[index];
+            if (a_slot.entry != nullptr && a_slot.entry.use_count() <= unretained_use_count) {
+                candidates.emplace_back(a_slot.entry->last_use.load(std::memory_order_relaxed), index);
+            }
+        }
+        std::ranges::sort(candidates);
+
+        std::size_t evicted_count = 0;
+        for (const auto [_, index] : candidates) {
+            if (byte_size_ <= budget_) {
+                break;
+            }
+            slot& a_slot = slots_[index];
+            // lookup copies references out of index_ without the mutex, so the count is final only once it is erased
+            index_.erase(a_slot.id);
+            if (a_slot.entry.use_count() > 1) {
+                index_.publish(a_slot.id, reference_type{ a_slot.reference.value(), a_slot.entry });
+                continue;
+            }
+            slot_by_id_.erase(a_slot.id);
+            // destroys the value along with what it owns, e.g. GL objects and layers of texture_arrays
+            std::ignore = storage_.erase(a_slot.id);
+            a_slot.reference = meta::null;
+            a_slot.entry = nullptr;
+            ++a_slot.generation;
+            byte_size_ -= a_slot.byte_size;
+            free_slots_.push_back(index);
+            ++evicted_count;
+        }
+        evict_count_ += evicted_count;
+        return evicted_count;
+    }
+
+    [[nodiscard]] resource_stats stats() const {
+        return resource_stats{
+            .hit_count = hit_count_.load(std::memory_order_relaxed),
+            .miss_count = miss_count_.load(std::memory_order_relaxed),
+            .evict_count = evict_count_,
+            .entry_count = slot_by_id_.size(),
+            .byte_size = byte_size_,
+            .budget = budget_,
+        };
+    }
+
+private:
+    // results of require_many, the caller is resumed by the last of pending_count completions
+    struct batch {
+        explicit batch(std::vector<meta::maybe<reference_type>> a_results) : results{ std::move(a_results) } {}
+
+        std::vector<meta::maybe<reference_type>> results;
+        std::atomic<std::size_t> pending_count{ 0 };
+        meta::maybe<exec::promise<meta::unit, meta::unit>> done{};
+    };
+
+    static void complete(batch& a_batch) {
+        if (a_batch.pending_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            a_batch.done.value().set_value(meta::unit{});
+        }
+    }
+
+    template <typename LoaderT>
+    exec::async<void> load_into(
+        meta::unique_string id,
+        LoaderT loader,
+        bool override_after_load,
+        std::shared_ptr<batch> a_batch,
+        std::size_t index
+    ) {
+        a_batch->results[index] = co_await load(id, std::move(loader), override_after_load);
+        complete(*a_batch);
+    }
+
+    template <typename FutureT>
+    exec::async<void> await_into(FutureT future, std::shared_ptr<batch> a_batch, std::size_t index) {
+        using exec::operator co_await;
+
+        auto result = co_await std::move(future);
+        if (result.has_value()) {
+            a_batch->results[index] = std::move(result).value();
+        }
+        complete(*a_batch);
+    }
+
+    // loader context of require, promises_by_id_ has to contain id
+    template <typename LoaderT>
+    exec::async<meta::maybe<reference_type>> load(meta::unique_string id, LoaderT loader, bool override_after_load) {
+        using exec::operator co_await;
+
         meta::maybe<T> maybe_loaded_value;
         if constexpr (exec::SomeSignal<LoaderT>) {
             if (auto result_loaded_value = co_await std::move(loader)) {
@@ -95,12 +489,13 @@ public: // behaviour
         exec::mutex_lock lock = (co_await mutex_.lock()).value();
         meta::maybe<reference_type> maybe_reference =
             std::move(maybe_loaded_value).map([this, id, override_after_load](T value) -> reference_type {
+                const std::size_t byte_size = detail::byte_size_of(value);
                 if (override_after_load) {
                     auto [reference, _] = storage_.insert(id, std::move(value));
-                    return reference;
+                    return publish(id, reference, byte_size);
                 } else {
-                    auto [reference, _] = storage_.emplace(id, std::move(value));
-                    return reference;
+                    auto [reference, is_inserted] = storage_.emplace(id, std::move(value));
+                    return publish(id, reference, is_inserted ? byte_size : detail::byte_size_of(*reference));
                 }
             });
 
@@ -112,7 +507,7 @@ public: // behaviour
 
         if (maybe_reference.has_value()) {
             for (promise_type& promise : promises) {
-                promise.set_value(reference_type{ maybe_reference.value() });
+                promise.set_value(maybe_reference.value());
             }
         } else {
             for (promise_type& promise : promises) {
@@ -120,46 +515,117 @@ public: // behaviour
             }
         }
 
+        // the value that was just loaded is the most recently used one, so it is not evicted right away
+        std::ignore = evict_unsafe();
+
         co_await std::move(lock).unlock();
         co_return maybe_reference;
     }
 
-    // There can be only awaiter context.
-    // If storage does not contain id and there is not a loader present - meta::null is returned.
-    //
-    exec::async<meta::maybe<reference_type>> request(meta::unique_string id) & {
-        using exec::operator co_await;
+    // one per own loaded value, reused after eviction with the next generation
+    struct slot {
+        meta::unique_string id;
+        meta::maybe<unsafe_reference_type> reference; // null if evicted
+        std::shared_ptr<detail::resource_entry> entry; // null if evicted
+        std::uint32_t generation;
+        std::size_t byte_size;
+    };
 
-        exec::mutex_lock lock = (co_await mutex_.lock()).value();
-        if (auto maybe_value = storage_.lookup(id)) {
-            co_return maybe_value.value();
-        }
+    // copies of an entry held by its slot and index_, any other one retains the value
+    static constexpr long unretained_use_count = 2;
 
-        const auto promises_it = promises_by_id_.find(id);
-        if (promises_it == promises_by_id_.end()) {
-            co_return meta::null;
+    [[nodiscard]] slot* slot_of(resource_handle handle) {
+        if (handle.index >= slots_.size()) {
+            return nullptr;
         }
+        slot& a_slot = slots_[handle.index];
+        if (a_slot.generation != handle.generation || !a_slot.reference.has_value()) {
+            return nullptr;
+        }
+        return &a_slot;
+    }
 
-        auto [future, promise] = exec::make_contract<reference_type, meta::unit>();
-        promises_it.value().push_back(std::move(promise));
-        co_await std::move(lock).unlock();
+    // marks the value as used for eviction, safe from any thread
+    void touch(detail::resource_entry& entry) {
+        entry.last_use.store(use_count_.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
 
-        auto result = co_await std::move(future);
-        if (result.has_value()) {
-            co_return std::move(result).value();
+    [[nodiscard]] unsafe_reference_type use(slot& a_slot) {
+        touch(*a_slot.entry);
+        return a_slot.reference.value();
+    }
+
+    // under mutex_, own values and then values of the parent
+    [[nodiscard]] meta::maybe<reference_type> find_unsafe(meta::unique_string id) {
+        if (const auto it = slot_by_id_.find(id); it != slot_by_id_.end()) {
+            slot& a_slot = slots_[it->second];
+            touch(*a_slot.entry);
+            return reference_type{ a_slot.reference.value(), a_slot.entry };
         }
-        co_return meta::null;
+        if (parent_ == nullptr) {
+            return meta::null;
+        }
+        return parent_->find_unsafe(id);
     }
 
-    [[nodiscard]] meta::maybe<reference_type> lookup_unsafe(meta::unique_string id) & { return storage_.lookup(id); }
-    [[nodiscard]] meta::maybe<const_reference_type> lookup_unsafe(meta::unique_string id) const& {
-        return storage_.lookup(id);
+    // under mutex_, in loader context
+    reference_type publish(meta::unique_string id, const unsafe_reference_type& reference, std::size_t byte_size) {
+        if (const auto it = slot_by_id_.find(id); it != slot_by_id_.end()) {
+            slot& a_slot = slots_[it->second];
+            byte_size_ = byte_size_ - a_slot.byte_size + byte_size;
+            a_slot.reference.emplace(reference);
+            a_slot.byte_size = byte_size;
+            touch(*a_slot.entry);
+            reference_type a_reference{ reference, a_slot.entry };
+            index_.publish(id, a_reference);
+            return a_reference;
+        }
+
+        slot new_slot{
+            .id = id,
+            .reference = reference,
+            .entry = std::make_shared<detail::resource_entry>(),
+            .generation = 0,
+            .byte_size = byte_size,
+        };
+        touch(*new_slot.entry);
+        reference_type a_reference{ reference, new_slot.entry };
+        index_.publish(id, a_reference);
+        std::uint32_t index = 0;
+        if (free_slots_.empty()) {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back(std::move(new_slot));
+        } else {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+            new_slot.generation = slots_[index].generation;
+            slots_[index] = std::move(new_slot);
+        }
+        slot_by_id_.emplace(id, index);
+        byte_size_ += byte_size;
+        return a_reference;
     }
 
 private:
     storage_type storage_;
     tsl::robin_map<meta::unique_string, std::vector<promise_type>> promises_by_id_{};
+    exec::executor& executor_;
     exec::mutex<> mutex_;
+    detail::resource_index<reference_type> index_{};
+    resource* parent_;
+
+    // dense handles and eviction state, same as storage_ are written by loaders and read by lookup_unsafe
+    // on the executor
+    std::vector<slot> slots_{};
+    std::vector<std::uint32_t> free_slots_{};
+    tsl::robin_map<meta::unique_string, std::uint32_t> slot_by_id_{};
+    std::atomic<std::uint64_t> use_count_{ 0 };
+    std::size_t byte_size_ = 0;
+    std::size_t budget_ = std::numeric_limits<std::size_t>::max();
+
+    std::atomic<std::size_t> hit_count_{ 0 };
+    std::atomic<std::size_t> miss_count_{ 0 };
+    std::size_t evict_count_ = 0;
 };
 
 } // namespace sl::ecs
@@ -0,0 +1,20 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace sl::ecs {
+
+// Dense index into a resource, resolved once from a string id, see resource::resolve_unsafe.
+// Generation changes once the slot is reused for another id, so that stale handles do not alias it.
+struct resource_handle {
+    std::uint32_t index;
+    std::uint32_t generation;
+
+    [[nodiscard]] bool operator==(const resource_handle&) const = default;
+};
+
+} // namespace sl::ecs
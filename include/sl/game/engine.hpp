@@ -5,3 +5,4 @@
 #pragma once
 
 #include "sl/game/engine/context.hpp"
+#include "sl/game/engine/worker_pool.hpp"
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "sl/game/engine/worker_pool.hpp"
 #include "sl/game/graphics/context.hpp"
 #include "sl/game/graphics/system/overlay.hpp"
 #include "sl/game/graphics/system/render.hpp"
@@ -11,8 +12,10 @@
 #include "sl/game/time.hpp"
 
 #include <sl/exec/algo/sched/manual.hpp>
+#include <sl/exec/algo/sched/start_on.hpp>
 #include <sl/exec/algo/sync/serial.hpp>
 #include <sl/exec/coro/async.hpp>
+#include <sl/exec/thread/pool/monolithic.hpp>
 #include <sl/meta/monad/maybe.hpp>
 #include <sl/rt/context.hpp>
 
@@ -29,6 +32,11 @@ struct engine_context {
 
     exec::async<meta::maybe<const time_point&>> next_frame();
 
+    // For loaders of ecs::resource::require: file reads, decoding and packing go after co_await of to_load_exec,
+    // GL calls after co_await of to_gl_exec, which resumes on script_exec, where the context is current.
+    [[nodiscard]] auto to_load_exec() const { return exec::start_on(*load_exec); }
+    [[nodiscard]] auto to_gl_exec() const { return exec::start_on(*script_exec); }
+
 public:
     rt::context rt_ctx;
     std::filesystem::path root_path;
@@ -38,6 +46,8 @@ public:
 
     std::unique_ptr<exec::manual_executor> script_exec;
     std::unique_ptr<exec::serial_executor<>> sync_exec;
+    std::unique_ptr<worker_pool> workers;
+    std::unique_ptr<exec::monolithic_thread_pool> load_exec; // for cpu work of loaders, frame work uses workers
 
     time t;
     meta::maybe<time_point> maybe_tp;
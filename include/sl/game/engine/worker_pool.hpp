@@ -0,0 +1,98 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include <sl/meta/traits/unique.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sl::game {
+
+// fork-join pool for data-parallel frame work, the calling thread participates in every job
+// parallel_for is not reentrant: it must not be called from inside of a job
+class worker_pool : meta::unique {
+public:
+    explicit worker_pool(std::size_t thread_count = default_thread_count());
+    ~worker_pool();
+
+    [[nodiscard]] static std::size_t default_thread_count();
+
+    // amount of threads executing a job, including the calling one
+    [[nodiscard]] std::size_t concurrency() const { return threads_.size() + 1; }
+
+    [[nodiscard]] static std::size_t chunk_count(std::size_t size, std::size_t grain) {
+        return (size + grain - 1) / grain;
+    }
+
+    // grain that gives every thread a few chunks to balance load, but not smaller than min_grain
+    [[nodiscard]] std::size_t grain_for(std::size_t size, std::size_t min_grain) const {
+        const std::size_t target_chunk_count = concurrency() * 4;
+        return std::max(min_grain, (size + target_chunk_count - 1) / target_chunk_count);
+    }
+
+    // splits [0, size) into chunk_count(size, grain) chunks of grain elements
+    // and invokes f(chunk_index, begin, end) once per chunk, blocks until all chunks are done
+    template <typename F>
+    void parallel_for(std::size_t size, std::size_t grain, F&& f) {
+        using f_type = std::remove_reference_t<F>;
+        run(size,
+            std::max<std::size_t>(grain, 1),
+            const_cast<void*>(static_cast<const void*>(std::addressof(f))),
+            [](void* f_ptr, std::size_t chunk_index, std::size_t begin, std::size_t end) {
+                (*static_cast<f_type*>(f_ptr))(chunk_index, begin, end);
+            });
+    }
+
+private:
+    using invoke_type = void (*)(void*, std::size_t, std::size_t, std::size_t);
+
+    struct job {
+        std::size_t size = 0;
+        std::size_t grain = 1;
+        std::size_t chunk_count = 0;
+        void* f_ptr = nullptr;
+        invoke_type invoke = nullptr;
+    };
+
+    void run(std::size_t size, std::size_t grain, void* f_ptr, invoke_type invoke);
+    void execute_chunks();
+    void worker_loop();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable job_cv_;
+    std::condition_variable done_cv_;
+
+    job job_{};
+    std::atomic<std::size_t> next_chunk_{ 0 };
+    std::uint64_t generation_ = 0;
+    std::size_t active_ = 0;
+    bool is_job_active_ = false;
+    bool is_stopped_ = false;
+
+    std::vector<std::jthread> threads_;
+};
+
+// runs f(0, 0, size) on the calling thread without workers, otherwise splits into chunks of at least min_grain
+template <typename F>
+void parallel_for(worker_pool* maybe_workers, std::size_t size, std::size_t min_grain, F&& f) {
+    if (maybe_workers == nullptr) {
+        f(std::size_t{ 0 }, std::size_t{ 0 }, size);
+        return;
+    }
+    maybe_workers->parallel_for(size, maybe_workers->grain_for(size, min_grain), std::forward<F>(f));
+}
+
+} // namespace sl::game
@@ -7,4 +7,7 @@
 #include "sl/game/graphics/buffer.hpp"
 #include "sl/game/graphics/component.hpp"
 #include "sl/game/graphics/context.hpp"
+#include "sl/game/graphics/geometry_pool.hpp"
+#include "sl/game/graphics/ssbo_mirror.hpp"
 #include "sl/game/graphics/system.hpp"
+#include "sl/game/graphics/texture_array.hpp"
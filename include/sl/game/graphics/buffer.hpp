@@ -5,14 +5,26 @@
 #pragma once
 
 #include "sl/game/detail/log.hpp"
+#include "sl/game/engine/worker_pool.hpp"
 #include "sl/game/graphics/component/basis.hpp"
 
 #include <sl/ecs/layer.hpp>
 #include <sl/gfx/vtx/buffer.hpp>
 #include <sl/meta/monad/maybe.hpp>
+#include <sl/meta/traits/unique.hpp>
 
 #include <sl/meta/assert.hpp>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
 namespace sl::game {
 
 template <typename SSBOElementT>
@@ -33,7 +45,173 @@ template <SSBOElement SSBOElementT, gfx::buffer_usage buffer_usage = gfx::buffer
     return ssbo;
 }
 
+// Capacity that grows geometrically, so that a growing count reallocates O(log n) times,
+// and shrinks only after the count stayed below a quarter of it for shrink_delay consecutive fits,
+// so that a count oscillating around a power of two does not reallocate every frame.
+struct ssbo_capacity_policy {
+    static constexpr std::size_t shrink_delay = 120;
+
+    std::size_t capacity = 0;
+    std::size_t shrink_streak = 0;
+
+    // returns whether capacity changed, buffer has to be reallocated then
+    [[nodiscard]] bool fit(std::size_t size) & {
+        if (capacity == 0 || size > capacity) {
+            capacity = std::bit_ceil(std::max<std::size_t>(size, 1));
+            shrink_streak = 0;
+            return true;
+        }
+        if (size * 4 > capacity) {
+            shrink_streak = 0;
+            return false;
+        }
+        if (++shrink_streak < shrink_delay) {
+            return false;
+        }
+        // leave room to grow back twice
+        const std::size_t shrunk_capacity = std::bit_ceil(std::max<std::size_t>(size * 2, 1));
+        shrink_streak = 0;
+        return std::exchange(capacity, shrunk_capacity) != shrunk_capacity;
+    }
+};
+
+// ssbo reallocated according to ssbo_capacity_policy, T does not have to be an SSBOElement
+template <typename T, gfx::buffer_usage buffer_usage = gfx::buffer_usage::dynamic_draw>
+class growable_ssbo {
+public:
+    using ssbo_type = gfx::buffer<T, gfx::buffer_type::shader_storage, buffer_usage>;
+
+    // returns whether buffer was reallocated, its contents are undefined then
+    bool reserve(std::size_t size) & {
+        if (!capacity_policy_.fit(size) && ssbo_.has_value()) {
+            return false;
+        }
+        log::trace("[growable_ssbo] {} capacity={}", typeid(T).name(), capacity_policy_.capacity);
+        ssbo_.emplace();
+        ssbo_.value().bind().initialize_data(capacity_policy_.capacity);
+        return true;
+    }
+
+    // reserves and overwrites the beginning of the buffer with data
+    void upload(std::span<const T> data) & {
+        reserve(data.size());
+        if (data.empty()) {
+            return;
+        }
+        auto bound_ssbo = ssbo_.value().bind();
+        auto maybe_mapped_ssbo = bound_ssbo.template map<gfx::buffer_access::write_only>();
+        auto mapped_ssbo = *ASSERT_VAL(std::move(maybe_mapped_ssbo));
+        std::ranges::copy(data, mapped_ssbo.data().begin());
+    }
+
+    // reserve has to be called before
+    [[nodiscard]] ssbo_type& ssbo() & { return ssbo_.value(); }
+    [[nodiscard]] auto bind_base(std::uint32_t index) & { return ssbo_.value().bind_base(index); }
+    [[nodiscard]] std::size_t capacity() const { return capacity_policy_.capacity; }
+
+private:
+    meta::maybe<ssbo_type> ssbo_{};
+    ssbo_capacity_policy capacity_policy_{};
+};
+
+// Persistently and coherently mapped ssbo split into frames_in_flight regions of capacity elements each.
+// Every frame writes into the next region, which is guarded by a fence of the frame that used it before,
+// so the driver never has to synchronize a map with draws still reading the buffer.
+// Usage per frame: begin_frame, write into the returned span, bind_range, draw, end_frame.
+template <SSBOElement SSBOElementT, std::size_t frames_in_flight = 3>
+class ring_ssbo : meta::unique {
+    static_assert(frames_in_flight > 0);
+
+public:
+    explicit ring_ssbo(std::size_t capacity) : capacity_{ capacity } {
+        GLint offset_alignment = 1;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+        const auto alignment = static_cast<std::size_t>(std::max(offset_alignment, 1));
+        region_stride_ = (capacity_ * sizeof(SSBOElementT) + alignment - 1) / alignment * alignment;
+
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const auto size = static_cast<GLsizeiptr>(std::max<std::size_t>(region_stride_ * frames_in_flight, 1));
+        glCreateBuffers(1, &buffer_);
+        glNamedBufferStorage(buffer_, size, nullptr, flags);
+        mapped_ = static_cast<std::byte*>(glMapNamedBufferRange(buffer_, 0, size, flags));
+        ASSERT(mapped_ != nullptr, "persistent mapping failed", capacity_);
+    }
+
+    ~ring_ssbo() {
+        for (GLsync& fence : fences_) {
+            if (fence != nullptr) {
+                glDeleteSync(std::exchange(fence, nullptr));
+            }
+        }
+        if (buffer_ != 0) {
+            glUnmapNamedBuffer(buffer_);
+            glDeleteBuffers(1, &buffer_);
+        }
+    }
+
+    // moves to the next region, waits until the gpu is done with it and returns it for writing
+    [[nodiscard]] std::span<SSBOElementT> begin_frame() & {
+        DEBUG_ASSERT(!is_frame_begun_, "end_frame was not called");
+        is_frame_begun_ = true;
+        region_ = (region_ + 1) % frames_in_flight;
+
+        if (GLsync fence = std::exchange(fences_[region_], nullptr); fence != nullptr) {
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                ++stall_count_;
+                do {
+                    status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait_timeout_ns);
+                } while (status == GL_TIMEOUT_EXPIRED);
+            }
+            DEBUG_ASSERT(status != GL_WAIT_FAILED);
+            glDeleteSync(fence);
+        }
+
+        return std::span{ reinterpret_cast<SSBOElementT*>(mapped_ + base_offset()), capacity_ };
+    }
+
+    // binds first size elements of the current region to the indexed ssbo binding
+    void bind_range(std::uint32_t index, std::size_t size) const {
+        DEBUG_ASSERT(is_frame_begun_ && size <= capacity_);
+        glBindBufferRange(
+            GL_SHADER_STORAGE_BUFFER,
+            index,
+            buffer_,
+            static_cast<GLintptr>(base_offset()),
+            static_cast<GLsizeiptr>(std::max<std::size_t>(size, 1) * sizeof(SSBOElementT))
+        );
+    }
+
+    // has to be called after the draws reading the current region were issued
+    void end_frame() & {
+        DEBUG_ASSERT(is_frame_begun_, "begin_frame was not called");
+        is_frame_begun_ = false;
+        fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // in bytes, of the current region
+    [[nodiscard]] std::size_t base_offset() const { return region_ * region_stride_; }
+    [[nodiscard]] std::size_t capacity() const { return capacity_; }
+    [[nodiscard]] bool is_frame_begun() const { return is_frame_begun_; }
+    // amount of begin_frame calls which had to wait for the gpu
+    [[nodiscard]] std::size_t stall_count() const { return stall_count_; }
+
+private:
+    static constexpr GLuint64 wait_timeout_ns = 1'000'000;
+
+    std::size_t capacity_;
+    std::size_t region_stride_ = 0;
+    std::size_t region_ = frames_in_flight - 1; // so that the first frame uses the first region
+    GLuint buffer_ = 0;
+    std::byte* mapped_ = nullptr;
+    std::array<GLsync, frames_in_flight> fences_{};
+    bool is_frame_begun_ = false;
+    std::size_t stall_count_ = 0;
+};
+
 // returns new size, which has to be set accordingly
+// rebuilds every element on each call, ssbo_mirror uploads only changed ones
+// elements past the capacity are dropped, growable_ssbo overload reserves for all of them
 template <SSBOElement SSBOElementT, gfx::buffer_usage buffer_usage>
 [[nodiscard]] std::uint32_t fill_ssbo(
     const ecs::layer& layer,
@@ -61,4 +239,146 @@ template <SSBOElement SSBOElementT, gfx::buffer_usage buffer_usage>
     return size_counter;
 };
 
+// reserves for every component of the view before mapping, so that nothing is dropped
+// returns new size, which has to be set accordingly
+template <SSBOElement SSBOElementT, gfx::buffer_usage buffer_usage>
+[[nodiscard]] std::uint32_t fill_ssbo(
+    const ecs::layer& layer,
+    const basis& world,
+    growable_ssbo<SSBOElementT, buffer_usage>& ssbo
+) {
+    const auto view = layer.registry.template view<typename SSBOElementT::component_type>();
+    ssbo.reserve(view.size_hint());
+    return fill_ssbo(layer, world, ssbo.ssbo());
+}
+
+// fills already mapped ssbo data from the given entities only, components are looked up per entity
+// returns amount of written elements
+template <SSBOElement SSBOElementT>
+[[nodiscard]] std::uint32_t fill_ssbo(
+    const ecs::layer& layer,
+    const basis& world,
+    std::span<SSBOElementT> mapped_ssbo_data,
+    std::span<const entt::entity> entities
+) {
+    // const registry yields nullptr if the storage was never created
+    const auto* maybe_storage = layer.registry.template storage<typename SSBOElementT::component_type>();
+    if (maybe_storage == nullptr) {
+        return 0;
+    }
+    const auto& storage = *maybe_storage;
+
+    std::uint32_t size_counter = 0;
+    for (const entt::entity entity : entities) {
+        if (const bool enough_capacity = size_counter < mapped_ssbo_data.size();
+            !DEBUG_ASSERT_VAL(enough_capacity, "", mapped_ssbo_data.size())) {
+            log::warn("exceeded limit of {} = {}", typeid(SSBOElementT).name(), mapped_ssbo_data.size());
+            break;
+        }
+        if (!storage.contains(entity)) {
+            continue;
+        }
+
+        if (auto maybe_element = SSBOElementT::from(layer, world, entity, storage.get(entity));
+            maybe_element.has_value()) {
+            mapped_ssbo_data[size_counter] = std::move(maybe_element).value();
+            ++size_counter;
+        }
+    }
+    return size_counter;
+}
+
+// below that entities are converted on the calling thread only
+inline constexpr std::size_t fill_ssbo_min_grain = 1024;
+
+// per chunk outputs of parallel fill_ssbo, reused between calls
+template <SSBOElement SSBOElementT>
+struct fill_ssbo_chunks {
+    std::vector<std::vector<SSBOElementT>> elements{};
+    std::vector<std::size_t> offsets{};
+};
+
+// Same as the serial one, but entities are split into chunks across workers.
+// Every chunk compacts its elements into its own output, an exclusive prefix sum of output sizes
+// gives every chunk its offset, then chunks are copied into mapped ssbo data in parallel.
+template <SSBOElement SSBOElementT>
+[[nodiscard]] std::uint32_t fill_ssbo(
+    const ecs::layer& layer,
+    const basis& world,
+    std::span<SSBOElementT> mapped_ssbo_data,
+    std::span<const entt::entity> entities,
+    worker_pool& workers,
+    fill_ssbo_chunks<SSBOElementT>& chunks
+) {
+    // const registry yields nullptr if the storage was never created
+    const auto* maybe_storage = layer.registry.template storage<typename SSBOElementT::component_type>();
+    if (maybe_storage == nullptr || entities.empty()) {
+        return 0;
+    }
+    const auto& storage = *maybe_storage;
+
+    const std::size_t grain = workers.grain_for(entities.size(), fill_ssbo_min_grain);
+    const std::size_t chunk_count = worker_pool::chunk_count(entities.size(), grain);
+    chunks.elements.resize(chunk_count);
+    chunks.offsets.resize(chunk_count + 1);
+
+    workers.parallel_for(entities.size(), grain, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+        std::vector<SSBOElementT>& chunk_elements = chunks.elements[chunk_index];
+        chunk_elements.clear();
+        for (const entt::entity entity : entities.subspan(begin, end - begin)) {
+            if (!storage.contains(entity)) {
+                continue;
+            }
+            if (auto maybe_element = SSBOElementT::from(layer, world, entity, storage.get(entity));
+                maybe_element.has_value()) {
+                chunk_elements.push_back(std::move(maybe_element).value());
+            }
+        }
+    });
+
+    chunks.offsets[0] = 0;
+    for (std::size_t chunk_index = 0; chunk_index < chunk_count; ++chunk_index) {
+        chunks.offsets[chunk_index + 1] = chunks.offsets[chunk_index] + chunks.elements[chunk_index].size();
+    }
+    const std::size_t size = chunks.offsets.back();
+    if (const bool enough_capacity = size <= mapped_ssbo_data.size();
+        !DEBUG_ASSERT_VAL(enough_capacity, "", mapped_ssbo_data.size())) {
+        log::warn("exceeded limit of {} = {}", typeid(SSBOElementT).name(), mapped_ssbo_data.size());
+    }
+
+    workers.parallel_for(chunk_count, 1, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t chunk_index = begin; chunk_index < end; ++chunk_index) {
+            const std::vector<SSBOElementT>& chunk_elements = chunks.elements[chunk_index];
+            const std::size_t offset = std::min(chunks.offsets[chunk_index], mapped_ssbo_data.size());
+            const std::size_t count = std::min(chunk_elements.size(), mapped_ssbo_data.size() - offset);
+            std::ranges::copy_n(chunk_elements.begin(), count, mapped_ssbo_data.begin() + offset);
+        }
+    });
+    return static_cast<std::uint32_t>(std::min(size, mapped_ssbo_data.size()));
+}
+
+// parallel variant for every component of the view, reserves before mapping
+template <SSBOElement SSBOElementT, gfx::buffer_usage buffer_usage>
+[[nodiscard]] std::uint32_t fill_ssbo(
+    const ecs::layer& layer,
+    const basis& world,
+    growable_ssbo<SSBOElementT, buffer_usage>& ssbo,
+    worker_pool& workers,
+    fill_ssbo_chunks<SSBOElementT>& chunks
+) {
+    const auto* maybe_storage = layer.registry.template storage<typename SSBOElementT::component_type>();
+    if (maybe_storage == nullptr) {
+        ssbo.reserve(0);
+        return 0;
+    }
+    const auto& storage = *maybe_storage;
+    ssbo.reserve(storage.size());
+
+    auto bound_ssbo = ssbo.ssbo().bind();
+    auto maybe_mapped_ssbo = bound_ssbo.template map<gfx::buffer_access::write_only>();
+    auto mapped_ssbo = *ASSERT_VAL(std::move(maybe_mapped_ssbo));
+    const std::span<const entt::entity> entities{ storage.data(), storage.size() };
+    return fill_ssbo(layer, world, mapped_ssbo.data(), entities, workers, chunks);
+}
+
 } // namespace sl::game
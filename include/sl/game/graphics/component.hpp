@@ -5,7 +5,10 @@
 #pragma once
 
 #include "sl/game/graphics/component/basis.hpp"
+#include "sl/game/graphics/component/bounds.hpp"
 #include "sl/game/graphics/component/camera.hpp"
+#include "sl/game/graphics/component/instance.hpp"
 #include "sl/game/graphics/component/overlay.hpp"
 #include "sl/game/graphics/component/transform.hpp"
+#include "sl/game/graphics/component/transform_soa.hpp"
 #include "sl/game/graphics/component/vertex.hpp"
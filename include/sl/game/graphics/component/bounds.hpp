@@ -0,0 +1,77 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/graphics/component/transform.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace sl::game {
+
+// axis aligned bounding box in model space
+struct aabb {
+    glm::vec3 min{ std::numeric_limits<float>::max() };
+    glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+    [[nodiscard]] bool is_empty() const { return glm::any(glm::greaterThan(min, max)); }
+    [[nodiscard]] glm::vec3 center() const { return (min + max) * 0.5f; }
+    [[nodiscard]] glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+    [[nodiscard]] float surface_area() const {
+        const glm::vec3 size = glm::max(max - min, glm::vec3{ 0.0f });
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    void extend(const glm::vec3& point) & {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void extend(const aabb& box) & {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+
+    // box around the transformed box, rotation makes it grow
+    [[nodiscard]] aabb transformed(const transform& tf) const {
+        const glm::mat3 rotation = glm::mat3_cast(tf.rot);
+        const glm::mat3 linear{ rotation[0] * tf.s.x, rotation[1] * tf.s.y, rotation[2] * tf.s.z };
+        const glm::mat3 abs_linear{ glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2]) };
+        const glm::vec3 a_center = linear * center() + tf.tr;
+        const glm::vec3 a_extent = abs_linear * extent();
+        return aabb{ .min = a_center - a_extent, .max = a_center + a_extent };
+    }
+
+    template <typename R, typename Proj>
+    [[nodiscard]] static aabb from_points(R&& range, Proj proj) {
+        aabb result;
+        for (const auto& x : range) {
+            result.extend(proj(x));
+        }
+        return result;
+    }
+};
+
+struct bounding_sphere {
+    glm::vec3 center;
+    float radius;
+
+    [[nodiscard]] static bounding_sphere from(const aabb& box) {
+        return bounding_sphere{ .center = box.center(), .radius = glm::length(box.extent()) };
+    }
+
+    // conservative for non-uniform scale
+    [[nodiscard]] bounding_sphere transformed(const transform& tf) const {
+        const glm::vec3 abs_s = glm::abs(tf.s);
+        return bounding_sphere{
+            .center = tf.rot * (center * tf.s) + tf.tr,
+            .radius = radius * std::max({ abs_s.x, abs_s.y, abs_s.z }),
+        };
+    }
+};
+
+} // namespace sl::game
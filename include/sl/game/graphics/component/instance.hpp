@@ -0,0 +1,42 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/graphics/component/basis.hpp"
+#include "sl/game/graphics/component/transform.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/meta/monad/maybe.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+namespace sl::game {
+
+// per-instance data for instanced shaders, read as
+// layout(std430, binding = 3) readonly buffer b_instances { instance b_instances_data[]; };
+// and indexed with gl_BaseInstance + gl_InstanceID
+struct instance_element {
+    using component_type = transform;
+
+    static constexpr std::uint32_t binding = 3;
+
+    [[nodiscard]] static meta::maybe<instance_element>
+        from(const ecs::layer& layer, const basis&, entt::entity entity, const component_type& component);
+
+public:
+    alignas(16) glm::mat4 model;
+    alignas(16) glm::mat4 it_model; // upper 3x3 is used for normals
+    // into b_materials of material_table if there is one, material_table::no_index otherwise
+    std::uint32_t material_index;
+};
+
+struct instance_range {
+    std::uint32_t base;
+    std::uint32_t count;
+};
+
+} // namespace sl::game
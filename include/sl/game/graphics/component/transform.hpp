@@ -11,6 +11,7 @@
 #include <sl/meta/conn/dirty.hpp>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -34,6 +35,11 @@ struct transform {
         return result;
     }
 
+    // model matrix: translate * rotate * scale
+    [[nodiscard]] glm::mat4 matrix() const {
+        return glm::scale(glm::translate(glm::mat4{ 1.0f }, tr) * glm::mat4_cast(rot), s);
+    }
+
     void translate(const glm::vec3& a_tr) & { tr += a_tr; }
     void rotate(const glm::quat& a_rot) & { rot = glm::normalize(a_rot * rot); }
     void scale(const glm::vec3& a_s) & { s = a_s; }
@@ -70,8 +76,25 @@ inline transform combine(const transform& a, const transform& b) {
     };
 }
 
+// Cached matrices of a world transform, opt-in: local_transform_system keeps it up to date for entities that have it,
+// recomputing only when their transform changes. Emplace it together with local_transform.
+struct world_matrix {
+    glm::mat4 model{ 1.0f };
+    glm::mat3 normal{ 1.0f }; // transpose(inverse(mat3(model)))
+
+    [[nodiscard]] static world_matrix from(const transform& tf) {
+        // (R * S)^-T = R * S^-1, so normal matrix needs no general inverse
+        const glm::mat3 rotation = glm::mat3_cast(tf.rot);
+        return world_matrix{
+            .model = tf.matrix(),
+            .normal{ rotation[0] / tf.s.x, rotation[1] / tf.s.y, rotation[2] / tf.s.z },
+        };
+    }
+};
+
 // for node updates use this one
 // local_transform_system will check if local_tranform is changed and apply transforms down the tree
+// in-place set() has to be followed by registry.patch<local_transform>, so that dirty_subtrees revisits the subtree
 using local_transform = meta::dirty<transform>;
 
 } // namespace sl::game
@@ -0,0 +1,50 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/graphics/component/transform.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// transforms laid out component by component, so that batch kernels load a register of lanes per component
+struct transform_soa {
+    std::vector<float> tr_x, tr_y, tr_z;
+    std::vector<float> rot_x, rot_y, rot_z, rot_w;
+    std::vector<float> s_x, s_y, s_z;
+
+    [[nodiscard]] std::size_t size() const { return tr_x.size(); }
+
+    void resize(std::size_t size);
+    void clear() { resize(0); }
+    void push_back(const transform& tf);
+
+    void set(std::size_t i, const transform& tf);
+    [[nodiscard]] transform get(std::size_t i) const;
+};
+
+// out[i] = combine(parent[i], local[i]), same as the scalar combine
+// if models is not empty, models[i] = out[i].matrix() is produced in the same pass
+// out may be the same object as parent or local, it is resized to parent.size()
+void combine(const transform_soa& parent, const transform_soa& local, transform_soa& out, std::span<glm::mat4> models);
+// same, but kernels wider than max_lane_count are skipped, so that each of them can be tested and measured
+void combine(
+    const transform_soa& parent,
+    const transform_soa& local,
+    transform_soa& out,
+    std::span<glm::mat4> models,
+    std::size_t max_lane_count
+);
+
+// amount of lanes processed at once by the widest kernel usable on this cpu: 8 for AVX2, 4 for SSE2, 1 otherwise,
+// the AVX2 kernel is built separately on x86-64 and selected at runtime
+[[nodiscard]] std::size_t combine_lane_count();
+
+} // namespace sl::game
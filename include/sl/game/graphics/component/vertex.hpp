@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include "sl/game/graphics/component/bounds.hpp"
+#include "sl/game/graphics/component/instance.hpp"
 #include "sl/game/graphics/context.hpp"
+#include "sl/game/graphics/texture_array.hpp"
 
 #include <sl/ecs.hpp>
 
@@ -18,6 +21,12 @@
 
 #include <glm/vec4.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <variant>
+
 namespace sl::game {
 
 struct texture {
@@ -27,12 +36,20 @@ struct texture {
 
 public:
     gfx::texture tex;
+    // optional, copy of the image in texture_arrays, lets material_table pack materials with this texture,
+    // the layer is freed along with the texture
+    meta::maybe<pooled_layer> layer{};
+    // optional, memory of the image, accounted against the budget of ecs::resource
+    std::size_t byte_size = 0;
 };
-using texture_or_color = std::variant<meta::persistent<texture>, glm::vec4>;
+// materials retain their textures, so that they are not evicted while the material exists
+using texture_or_color = std::variant<ecs::resource_reference<texture>, glm::vec4>;
 
 struct material {
     struct id {
         meta::unique_string id;
+        // optional, resolved on first lookup through resource::lookup_unsafe(id, handle)
+        meta::maybe<ecs::resource_handle> handle{};
     };
 
 public:
@@ -41,6 +58,35 @@ public:
     float shininess;
 };
 
+class geometry_pool_base;
+
+// location of a mesh in buffers of a geometry_pool, indices are std::uint32_t
+struct geometry_range {
+    std::uint32_t first_index;
+    std::uint32_t index_count;
+    std::int32_t base_vertex;
+};
+
+// Allocation of a vertex in a geometry_pool, whose vertices share its vertex array.
+// Freed on destruction, its range may be moved by compaction of the pool, so it is looked up on every draw.
+// Keeps the pool alive, so that vertices may outlive the pool's owner on layer.root.
+class pooled_geometry {
+public:
+    pooled_geometry(std::shared_ptr<geometry_pool_base> pool, std::uint32_t slot)
+        : pool_{ std::move(pool) }, slot_{ slot } {}
+    pooled_geometry(pooled_geometry&& other) noexcept : pool_{ std::move(other.pool_) }, slot_{ other.slot_ } {}
+    pooled_geometry& operator=(pooled_geometry&& other) noexcept;
+    ~pooled_geometry();
+
+    [[nodiscard]] geometry_pool_base& pool() const { return *pool_; }
+    [[nodiscard]] std::uint32_t slot() const { return slot_; }
+    [[nodiscard]] geometry_range range() const;
+
+private:
+    std::shared_ptr<geometry_pool_base> pool_;
+    std::uint32_t slot_;
+};
+
 struct vertex {
     struct id {
         meta::unique_string id;
@@ -48,10 +94,19 @@ struct vertex {
 
     // closure for vb/eb
     using draw_type = meta::unique_function<void(gfx::draw&)>;
+    // optional, draws instance_count instances starting from base_instance in a single call
+    using draw_instanced_type =
+        meta::unique_function<void(gfx::draw&, std::uint32_t base_instance, std::uint32_t instance_count)>;
 
 public:
-    gfx::vertex_array va;
+    // own vertex array, or a range of a shared one, instanced batches of which are merged into multi draws
+    std::variant<gfx::vertex_array, pooled_geometry> va;
     draw_type draw;
+    draw_instanced_type draw_instanced{};
+    // optional, model space bounds of vertices, without them entities are never culled
+    meta::maybe<aabb> bounds{};
+    // optional, memory of vertices and indices, accounted against the budget of ecs::resource
+    std::size_t byte_size = 0;
 };
 
 struct shader {
@@ -64,6 +119,14 @@ struct shader {
     using draw_type =
         meta::unique_function<void(const gfx::bound_vertex_array&, vertex::draw_type&, std::span<const entt::entity>)>;
     meta::unique_function<draw_type(ecs::layer&, const camera_frame&, const gfx::bound_shader_program&)> setup;
+
+    // optional, if present graphics_system uploads instance_element for every (shader, vertex) batch
+    // and issues one instanced draw per batch instead of calling setup's draw per entity,
+    // it is called right after the program is bound, before setup
+    using draw_instanced_type =
+        meta::unique_function<void(const gfx::bound_vertex_array&, vertex::draw_instanced_type&, instance_range)>;
+    meta::unique_function<draw_instanced_type(ecs::layer&, const camera_frame&, const gfx::bound_shader_program&)>
+        setup_instanced{};
 };
 
 struct primitive {
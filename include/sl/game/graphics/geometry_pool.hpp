@@ -0,0 +1,230 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/graphics/component/bounds.hpp"
+#include "sl/game/graphics/component/vertex.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/gfx/vtx/buffer.hpp>
+#include <sl/gfx/vtx/vertex_array.hpp>
+#include <sl/meta/monad/maybe.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// layout of a glMultiDrawElementsIndirect command
+struct draw_elements_indirect_command {
+    std::uint32_t count;
+    std::uint32_t instance_count;
+    std::uint32_t first_index;
+    std::int32_t base_vertex;
+    std::uint32_t base_instance;
+};
+
+struct geometry_pool_stats {
+    // of vertices or indices, in elements
+    struct space {
+        std::size_t used = 0;
+        std::size_t size = 0;
+        std::size_t free_block_count = 0;
+        std::size_t largest_free_block = 0;
+
+        [[nodiscard]] float utilization() const {
+            return size == 0 ? 1.0f : static_cast<float>(used) / static_cast<float>(size);
+        }
+        // share of free space which is not in the largest block, 0 if free space is contiguous
+        [[nodiscard]] float fragmentation() const {
+            const std::size_t free = size - used;
+            return free == 0 ? 0.0f : 1.0f - static_cast<float>(largest_free_block) / static_cast<float>(free);
+        }
+    };
+
+    space vertices;
+    space indices;
+    std::size_t allocation_count = 0;
+    std::size_t compaction_count = 0;
+    std::size_t rebuild_count = 0;
+};
+
+// first fit over free blocks ordered by offset, adjacent blocks are merged on release
+class geometry_free_list {
+public:
+    [[nodiscard]] meta::maybe<std::uint32_t> acquire(std::uint32_t count);
+    void release(std::uint32_t offset, std::uint32_t count);
+    // removes the block which ends at size, if there is one, and returns the size without it
+    [[nodiscard]] std::uint32_t trim(std::uint32_t size);
+    void clear() { blocks_.clear(); }
+
+    [[nodiscard]] std::size_t block_count() const { return blocks_.size(); }
+    [[nodiscard]] std::uint32_t largest_block() const;
+
+private:
+    std::map<std::uint32_t, std::uint32_t> blocks_; // offset to count
+};
+
+// Vertex layout independent part of geometry_pool: allocation, compaction and drawing.
+// Vertices and indices are allocated from separate free lists, indices are relative to the first vertex.
+// Shared by the owner on layer.root and by every pooled_geometry, so it outlives all of its vertices.
+class geometry_pool_base : public std::enable_shared_from_this<geometry_pool_base>, meta::unique {
+public:
+    using index_type = std::uint32_t;
+    static constexpr GLenum index_gl_type = GL_UNSIGNED_INT;
+
+    // share of free elements at which the pool is compacted before its buffers are rebuilt
+    static constexpr float compact_threshold = 0.25f;
+    // elements of each of vertices and indices moved by one rebuild at most, compaction continues with the next one
+    static constexpr std::uint32_t compact_step_size = 1u << 16;
+
+public:
+    virtual ~geometry_pool_base() = default;
+
+    // shared by all vertices of the pool, rebuilt if geometry was added or freed since the last call
+    [[nodiscard]] gfx::vertex_array& va() &;
+
+    // vertex which draws the allocation from the shared buffers and frees it once destroyed,
+    // draw_instanced draws it with glDrawElements*BaseInstance
+    [[nodiscard]] vertex vertex_of(pooled_geometry allocation, meta::maybe<aabb> bounds = meta::null) &;
+
+    [[nodiscard]] geometry_range range(std::uint32_t slot) const;
+    void free(std::uint32_t slot) &;
+
+    // moves all allocations to the beginning of the buffers at once, ranges of pooled_geometry change
+    void compact() &;
+
+    [[nodiscard]] geometry_pool_stats stats() const;
+
+protected:
+    // offsets and counts are in elements
+    struct allocation {
+        std::uint32_t vertex_offset;
+        std::uint32_t vertex_count;
+        std::uint32_t index_offset;
+        std::uint32_t index_count;
+        bool is_live;
+    };
+
+    enum class storage { vertices, indices };
+
+    // returns the slot, vertex and index storage is resized if needed
+    [[nodiscard]] std::uint32_t allocate(std::uint32_t vertex_count, std::uint32_t index_count);
+    // moves allocations from the end of the storage into the first free blocks which fit them,
+    // until max_count elements are moved, returns amount of moved elements
+    std::uint32_t compact_tail(storage a_storage, std::uint32_t max_count);
+
+    virtual void resize(std::uint32_t vertex_size, std::uint32_t index_size) = 0;
+    // source and destination may overlap, destination is never after the source
+    virtual void move_vertices(std::uint32_t from, std::uint32_t to, std::uint32_t count) = 0;
+    virtual void move_indices(std::uint32_t from, std::uint32_t to, std::uint32_t count) = 0;
+    virtual void rebuild() = 0;
+
+protected:
+    std::vector<allocation> allocations_;
+    std::vector<std::uint32_t> free_slots_;
+    geometry_free_list vertex_free_list_;
+    geometry_free_list index_free_list_;
+    std::uint32_t vertex_size_ = 0;
+    std::uint32_t index_size_ = 0;
+    std::uint32_t vertex_used_ = 0;
+    std::uint32_t index_used_ = 0;
+
+    meta::maybe<gfx::vertex_array> va_{};
+    bool is_dirty_ = false;
+    std::vector<std::uint32_t> tail_slots_{};
+    std::size_t compaction_count_ = 0;
+    std::size_t rebuild_count_ = 0;
+};
+
+// Shared vertex and element buffers of every mesh with vertex layout VT, so that instanced batches of all of its
+// vertices bind one vertex array and are drawn by one glMultiDrawElementsIndirect, see graphics_system.
+// Meshes get (offset, count) ranges from free lists and return them once their vertex is destroyed.
+// Geometry is kept on the cpu as well, buffers are reuploaded as a whole after changes,
+// which is expected to happen during loading and eviction only.
+template <typename VT>
+class geometry_pool final : public geometry_pool_base {
+public:
+    using ptr_type = std::shared_ptr<geometry_pool>;
+
+public:
+    static ptr_type make() { return ptr_type{ new geometry_pool{} }; }
+
+    // created on first use and kept on layer.root, one per vertex layout
+    static geometry_pool& of(ecs::layer& layer) {
+        if (auto* maybe_pool = layer.registry.template try_get<ptr_type>(layer.root); maybe_pool != nullptr) {
+            return **maybe_pool;
+        }
+        return *layer.registry.template emplace<ptr_type>(layer.root, make());
+    }
+
+    // indices are relative to vertices, as for a separate vertex array
+    template <std::unsigned_integral IndexT>
+    [[nodiscard]] pooled_geometry add(std::span<const VT> vertices, std::span<const IndexT> indices) & {
+        const std::uint32_t slot =
+            allocate(static_cast<std::uint32_t>(vertices.size()), static_cast<std::uint32_t>(indices.size()));
+        const allocation& an_allocation = allocations_[slot];
+        std::ranges::copy(vertices, vertices_.begin() + an_allocation.vertex_offset);
+        std::ranges::transform(indices, indices_.begin() + an_allocation.index_offset, [](IndexT index) {
+            return static_cast<index_type>(index);
+        });
+        return pooled_geometry{ shared_from_this(), slot };
+    }
+
+private:
+    geometry_pool() = default;
+
+    void resize(std::uint32_t vertex_size, std::uint32_t index_size) override {
+        vertices_.resize(vertex_size);
+        indices_.resize(index_size);
+    }
+    void move_vertices(std::uint32_t from, std::uint32_t to, std::uint32_t count) override {
+        std::copy_n(vertices_.begin() + from, count, vertices_.begin() + to);
+    }
+    void move_indices(std::uint32_t from, std::uint32_t to, std::uint32_t count) override {
+        std::copy_n(indices_.begin() + from, count, indices_.begin() + to);
+    }
+
+    void rebuild() override {
+        // vertex array goes first, since it references buffers
+        va_ = meta::null;
+        gfx::vertex_array_builder va_builder;
+        va_builder.template attributes_from<VT>();
+        vb_.emplace(va_builder.template buffer<gfx::buffer_type::array, gfx::buffer_usage::static_draw>(
+            std::span<const VT>{ vertices_ }
+        ));
+        eb_.emplace(va_builder.template buffer<gfx::buffer_type::element_array, gfx::buffer_usage::static_draw>(
+            std::span<const index_type>{ indices_ }
+        ));
+        va_.emplace(std::move(va_builder).submit());
+    }
+
+private:
+    std::vector<VT> vertices_;
+    std::vector<index_type> indices_;
+    meta::maybe<gfx::buffer<VT, gfx::buffer_type::array, gfx::buffer_usage::static_draw>> vb_{};
+    meta::maybe<gfx::buffer<index_type, gfx::buffer_type::element_array, gfx::buffer_usage::static_draw>> eb_{};
+};
+
+// GL_DRAW_INDIRECT_BUFFER reallocated for every multi draw, commands are built on the cpu
+class indirect_command_buffer : meta::unique {
+public:
+    indirect_command_buffer() = default;
+    ~indirect_command_buffer();
+
+    // uploads commands and draws them with the vertex array that is bound
+    void multi_draw(std::span<const draw_elements_indirect_command> commands) &;
+
+private:
+    GLuint buffer_ = 0;
+};
+
+} // namespace sl::game
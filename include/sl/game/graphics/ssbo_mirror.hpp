@@ -0,0 +1,242 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/graphics/buffer.hpp"
+#include "sl/game/graphics/component/transform.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <tsl/robin_map.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// Persistent GPU copy of SSBOElementT of every entity with its component_type.
+// Changes are observed through registry signals of component_type and transform, so only changed elements are
+// recomputed and only their ranges are uploaded. In-place modifications of the component have to be followed by
+// registry.patch<component_type>(entity), transforms are patched by local_transform_system.
+// Once changes are consumed update does nothing, so it may be called by every camera and shader within a frame.
+// Element order is unspecified, removed elements are replaced by the last one.
+template <SSBOElement SSBOElementT>
+class ssbo_mirror : meta::unique {
+public:
+    using ptr_type = std::unique_ptr<ssbo_mirror>;
+    using component_type = typename SSBOElementT::component_type;
+
+    // slots closer than that are uploaded by a single call, together with unchanged slots in between
+    static constexpr std::uint32_t merge_distance = 16;
+
+    // all entities are considered changed initially, since changes before creation were not observed
+    static ptr_type make(ecs::layer& layer) { return ptr_type{ new ssbo_mirror{ layer } }; }
+
+    // created on first use and kept on layer.root, so that all shaders share it
+    static ssbo_mirror& of(ecs::layer& layer) {
+        if (auto* maybe_mirror = layer.registry.template try_get<ptr_type>(layer.root); maybe_mirror != nullptr) {
+            return **maybe_mirror;
+        }
+        return *layer.registry.template emplace<ptr_type>(layer.root, make(layer));
+    }
+
+    ~ssbo_mirror() {
+        auto& registry = layer_.registry;
+        registry.template on_construct<component_type>().disconnect(*this);
+        registry.template on_update<component_type>().disconnect(*this);
+        registry.template on_destroy<component_type>().disconnect(*this);
+        registry.template on_construct<transform>().disconnect(*this);
+        registry.template on_update<transform>().disconnect(*this);
+        registry.template on_destroy<transform>().disconnect(*this);
+    }
+
+    // recomputes elements of changed entities and uploads their slots
+    void update(const basis& world) {
+        uploaded_count_ = 0;
+        if (is_structure_dirty_) {
+            rebuild(world);
+            return;
+        }
+        if (marked_.empty()) {
+            return;
+        }
+
+        std::ranges::sort(marked_);
+        const auto [unique_end, _] = std::ranges::unique(marked_);
+        marked_.erase(unique_end, marked_.end());
+
+        const auto& registry = layer_.registry;
+        for (const entt::entity entity : marked_) {
+            // destroyed components are still present while their signals are emitted, so recheck them here
+            const auto* maybe_component =
+                registry.valid(entity) ? registry.template try_get<component_type>(entity) : nullptr;
+            if (maybe_component == nullptr) {
+                remove(entity);
+                continue;
+            }
+            if (auto maybe_element = SSBOElementT::from(layer_, world, entity, *maybe_component);
+                maybe_element.has_value()) {
+                assign(entity, std::move(maybe_element).value());
+            } else {
+                remove(entity);
+            }
+        }
+        marked_.clear();
+
+        upload();
+    }
+
+    // buffer stays bound while the result is alive, update has to be called before
+    [[nodiscard]] auto bind_base(std::uint32_t index) & { return ssbo_.bind_base(index); }
+
+    [[nodiscard]] std::span<const SSBOElementT> elements() const { return elements_; }
+    [[nodiscard]] std::uint32_t size() const { return static_cast<std::uint32_t>(elements_.size()); }
+    // amount of elements uploaded by the last update
+    [[nodiscard]] std::size_t uploaded_count() const { return uploaded_count_; }
+
+private:
+    explicit ssbo_mirror(ecs::layer& layer) : layer_{ layer } {
+        auto& registry = layer_.registry;
+        registry.template on_construct<component_type>().template connect<&ssbo_mirror::on_change>(*this);
+        registry.template on_update<component_type>().template connect<&ssbo_mirror::on_change>(*this);
+        registry.template on_destroy<component_type>().template connect<&ssbo_mirror::on_change>(*this);
+        registry.template on_construct<transform>().template connect<&ssbo_mirror::on_transform_change>(*this);
+        registry.template on_update<transform>().template connect<&ssbo_mirror::on_transform_change>(*this);
+        registry.template on_destroy<transform>().template connect<&ssbo_mirror::on_transform_change>(*this);
+    }
+
+    void on_change(entt::registry&, entt::entity entity) { marked_.push_back(entity); }
+    void on_transform_change(entt::registry& registry, entt::entity entity) {
+        if (registry.template all_of<component_type>(entity)) {
+            marked_.push_back(entity);
+        }
+    }
+
+    void rebuild(const basis& world) {
+        is_structure_dirty_ = false;
+        marked_.clear();
+        elements_.clear();
+        entities_.clear();
+        slot_by_entity_.clear();
+
+        const auto& registry = layer_.registry;
+        for (const auto& [entity, component] : registry.template view<component_type>().each()) {
+            if (auto maybe_element = SSBOElementT::from(layer_, world, entity, component); maybe_element.has_value()) {
+                slot_by_entity_.emplace(entity, static_cast<std::uint32_t>(elements_.size()));
+                elements_.push_back(std::move(maybe_element).value());
+                entities_.push_back(entity);
+            }
+        }
+
+        ssbo_.reserve(elements_.size());
+        upload_all();
+    }
+
+    void assign(entt::entity entity, SSBOElementT element) {
+        if (const auto it = slot_by_entity_.find(entity); it != slot_by_entity_.end()) {
+            elements_[it->second] = std::move(element);
+            dirty_slots_.push_back(it->second);
+            return;
+        }
+        const auto slot = static_cast<std::uint32_t>(elements_.size());
+        slot_by_entity_.emplace(entity, slot);
+        elements_.push_back(std::move(element));
+        entities_.push_back(entity);
+        dirty_slots_.push_back(slot);
+    }
+
+    void remove(entt::entity entity) {
+        const auto it = slot_by_entity_.find(entity);
+        if (it == slot_by_entity_.end()) {
+            return;
+        }
+        const std::uint32_t slot = it->second;
+        slot_by_entity_.erase(it);
+
+        const auto last_slot = static_cast<std::uint32_t>(elements_.size() - 1);
+        if (slot != last_slot) {
+            elements_[slot] = std::move(elements_[last_slot]);
+            entities_[slot] = entities_[last_slot];
+            slot_by_entity_[entities_[slot]] = slot;
+            dirty_slots_.push_back(slot);
+        }
+        elements_.pop_back();
+        entities_.pop_back();
+    }
+
+    void upload() {
+        if (ssbo_.reserve(elements_.size())) {
+            upload_all();
+            return;
+        }
+
+        const auto size = static_cast<std::uint32_t>(elements_.size());
+        std::ranges::sort(dirty_slots_);
+        const auto [unique_end, _] = std::ranges::unique(dirty_slots_);
+        dirty_slots_.erase(unique_end, dirty_slots_.end());
+        // slots past the end were removed, size is passed to the shader separately
+        while (!dirty_slots_.empty() && dirty_slots_.back() >= size) {
+            dirty_slots_.pop_back();
+        }
+        if (dirty_slots_.empty()) {
+            return;
+        }
+
+        auto bound_ssbo = ssbo_.ssbo().bind();
+        std::uint32_t begin = dirty_slots_.front();
+        std::uint32_t end = begin + 1;
+        for (const std::uint32_t slot : std::span{ dirty_slots_ }.subspan(1)) {
+            if (slot - end < merge_distance) {
+                end = slot + 1;
+                continue;
+            }
+            upload_range(begin, end);
+            begin = slot;
+            end = slot + 1;
+        }
+        upload_range(begin, end);
+        dirty_slots_.clear();
+    }
+
+    // buffer has to be reserved
+    void upload_all() {
+        dirty_slots_.clear();
+        if (elements_.empty()) {
+            return;
+        }
+        auto bound_ssbo = ssbo_.ssbo().bind();
+        upload_range(0, static_cast<std::uint32_t>(elements_.size()));
+    }
+
+    // buffer has to be bound
+    void upload_range(std::uint32_t begin, std::uint32_t end) {
+        glBufferSubData(
+            GL_SHADER_STORAGE_BUFFER,
+            static_cast<GLintptr>(begin * sizeof(SSBOElementT)),
+            static_cast<GLsizeiptr>((end - begin) * sizeof(SSBOElementT)),
+            elements_.data() + begin
+        );
+        uploaded_count_ += end - begin;
+    }
+
+private:
+    ecs::layer& layer_;
+    bool is_structure_dirty_ = true;
+    std::vector<entt::entity> marked_{};
+
+    std::vector<SSBOElementT> elements_{};
+    std::vector<entt::entity> entities_{}; // per slot
+    tsl::robin_map<entt::entity, std::uint32_t> slot_by_entity_{};
+    std::vector<std::uint32_t> dirty_slots_{};
+
+    growable_ssbo<SSBOElementT> ssbo_{};
+    std::size_t uploaded_count_ = 0;
+};
+
+} // namespace sl::game
@@ -4,6 +4,11 @@
 
 #pragma once
 
+#include "sl/game/graphics/system/batch.hpp"
+#include "sl/game/graphics/system/cull.hpp"
+#include "sl/game/graphics/system/draw_queue.hpp"
+#include "sl/game/graphics/system/material.hpp"
 #include "sl/game/graphics/system/overlay.hpp"
 #include "sl/game/graphics/system/render.hpp"
+#include "sl/game/graphics/system/spatial.hpp"
 #include "sl/game/graphics/system/transform.hpp"
@@ -0,0 +1,91 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include <sl/ecs/layer.hpp>
+#include <sl/ecs/resource_handle.hpp>
+
+#include <sl/meta/monad/maybe.hpp>
+#include <sl/meta/storage/unique_string.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <tsl/robin_map.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace sl::game {
+
+// Incremental index of entities grouped by (shader::id, vertex::id).
+// Kept up to date by registry hooks, so a frame without changes costs no allocations and no rebuild.
+struct draw_batch_cache : meta::unique {
+    using ptr_type = std::unique_ptr<draw_batch_cache>;
+
+    struct batch {
+        std::vector<entt::entity> entities;
+        bool is_sorted = true;
+    };
+
+    using vertex_to_batch = tsl::robin_map</* vertex */ meta::unique_string, batch>;
+    using shader_to_vertex_to_batch = tsl::robin_map</* shader */ meta::unique_string, vertex_to_batch>;
+
+public:
+    static ptr_type make(entt::registry& registry) { return ptr_type{ new draw_batch_cache{ registry } }; }
+
+    ~draw_batch_cache();
+
+    // sorts batches that were touched since the previous call and drops empty ones,
+    // entities in every batch are sorted for deterministic and cache-friendly iteration
+    [[nodiscard]] const shader_to_vertex_to_batch& prepare() &;
+
+    [[nodiscard]] std::size_t size() const { return key_by_entity_.size(); }
+    // changes whenever a batch is added or removed, so that per batch data can be kept between frames
+    [[nodiscard]] std::size_t layout_version() const { return layout_version_; }
+
+private:
+    explicit draw_batch_cache(entt::registry& registry);
+
+    void on_construct(entt::registry& registry, entt::entity entity);
+    void on_update(entt::registry& registry, entt::entity entity);
+    void on_destroy(entt::registry& registry, entt::entity entity);
+
+    void insert(entt::entity entity, meta::unique_string shader_id, meta::unique_string vertex_id);
+    void erase(entt::entity entity);
+
+private:
+    struct key {
+        meta::unique_string shader_id;
+        meta::unique_string vertex_id;
+        std::size_t index; // position in batch::entities, allows O(1) removal
+    };
+
+    entt::registry& registry_;
+    shader_to_vertex_to_batch sv_map_{};
+    tsl::robin_map<entt::entity, key> key_by_entity_{};
+    bool is_dirty_ = false;
+    std::size_t layout_version_ = 0;
+};
+
+// Resource handles of every batch in shader_to_vertex_to_batch iteration order, resolved on first lookup,
+// so that per frame lookups of shaders and vertices are array accesses instead of string hash lookups.
+// Kept between frames while layout_version is the same, since batch indices are stable until then.
+struct batch_handles {
+    struct entry {
+        meta::maybe<ecs::resource_handle> shader{};
+        meta::maybe<ecs::resource_handle> vertex{};
+    };
+
+public:
+    void prepare(std::size_t batch_count, std::size_t layout_version);
+
+public:
+    std::vector<entry> entries{};
+
+private:
+    meta::maybe<std::size_t> layout_version_{};
+};
+
+} // namespace sl::game
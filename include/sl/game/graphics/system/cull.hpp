@@ -0,0 +1,79 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/engine/worker_pool.hpp"
+#include "sl/game/graphics/component/vertex.hpp"
+#include "sl/game/graphics/context.hpp"
+#include "sl/game/graphics/system/batch.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/ecs/resource.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// planes point inwards: sphere is outside if dot(plane.xyz, center) + plane.w < -radius for any of them
+struct frustum {
+    std::array<glm::vec4, 6> planes;
+
+    [[nodiscard]] static frustum from(const camera_frame& camera_frame);
+};
+
+// visible entities of every batch for one camera, batches are in shader_to_vertex_to_batch iteration order
+struct camera_visibility {
+    camera_frame frame;
+    std::vector<entt::entity> entities{}; // storage for culled batches
+    std::vector<std::span<const entt::entity>> batches{};
+};
+
+// Tests world space bounding spheres of batched entities against camera frusta.
+// Spheres are computed once per frame and kept as SoA, so that the plane test vectorizes;
+// both stages are split across workers for large entity counts.
+class frustum_culling {
+public:
+    // computes spheres for every batch in sv_map iteration order, batches of vertices without bounds are not culled,
+    // handles are of the same batches
+    void prepare(
+        ecs::layer& layer,
+        ecs::resource<vertex>& vertex_resource,
+        const draw_batch_cache::shader_to_vertex_to_batch& sv_map,
+        std::span<batch_handles::entry> handles,
+        worker_pool* workers
+    );
+
+    void execute(const frustum& a_frustum, camera_visibility& visibility, worker_pool* workers);
+
+    // for the last frame, summed over cameras
+    [[nodiscard]] std::size_t tested_count() const { return tested_count_; }
+    [[nodiscard]] std::size_t culled_count() const { return culled_count_; }
+
+private:
+    struct batch_spheres {
+        std::span<const entt::entity> entities;
+        std::size_t offset; // into spheres, npos if not culled
+    };
+    static constexpr std::size_t npos = ~std::size_t{ 0 };
+
+private:
+    std::vector<batch_spheres> batches_;
+
+    // one entry per culled entity
+    std::vector<entt::entity> entities_;
+    std::vector<bounding_sphere> local_spheres_;
+    std::vector<float> center_x_, center_y_, center_z_, radius_;
+    std::vector<std::uint8_t> is_visible_;
+
+    std::size_t tested_count_ = 0;
+    std::size_t culled_count_ = 0;
+};
+
+} // namespace sl::game
@@ -0,0 +1,120 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/graphics/system/batch.hpp"
+#include "sl/game/graphics/system/cull.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/meta/monad/maybe.hpp>
+#include <sl/meta/storage/unique_string.hpp>
+
+#include <tsl/robin_map.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// 64 bits, most significant first: shader rank | vertex rank | material rank | view depth,
+// so that sorting groups draws by program, then by vertex array, then by material and draws front to back
+struct draw_key {
+    static constexpr std::uint32_t shader_bits = 12;
+    static constexpr std::uint32_t vertex_bits = 12;
+    static constexpr std::uint32_t material_bits = 16;
+    static constexpr std::uint32_t depth_bits = 24;
+    static_assert(shader_bits + vertex_bits + material_bits + depth_bits == 64);
+
+    [[nodiscard]] static std::uint64_t
+        make(std::uint32_t shader_rank, std::uint32_t vertex_rank, std::uint32_t material_rank, float depth);
+
+    // positive floats compare as their bits, so the top bits of a non-negative depth are an ordered key
+    [[nodiscard]] static std::uint32_t depth_key(float depth);
+};
+
+// per frame counters of graphics_system, summed over cameras
+struct draw_stats {
+    std::size_t program_bind_count = 0;
+    std::size_t vertex_array_bind_count = 0;
+    std::size_t material_change_count = 0; // in draw order, so the upper bound of material applies
+    std::size_t draw_count = 0; // instanced batches and per entity draw calls of shaders
+    std::size_t multi_draw_command_count = 0; // instanced batches merged into multi draws, counted once in draw_count
+    // of material_binder, texture binds and material applies skipped by shader draws
+    std::size_t texture_bind_count = 0;
+    std::size_t redundant_bind_count = 0;
+
+    void reset() { *this = draw_stats{}; }
+};
+
+// Orders visible entities of a camera by draw_key with an LSD radix sort.
+// Shaders and vertices are ranked by their id strings, materials by first appearance,
+// so the order does not depend on hash map iteration. Material ranks are forgotten once material_table changes,
+// so that ids of materials which are gone do not accumulate.
+class draw_queue {
+public:
+    // consecutive entities of one batch, runs of one shader are adjacent
+    struct run {
+        meta::unique_string shader_id;
+        meta::unique_string vertex_id;
+        std::uint32_t batch_index; // in shader_to_vertex_to_batch iteration order
+        std::span<const entt::entity> entities; // sorted by material and depth, empty for instanced batches
+    };
+
+public:
+    // ranks batches of sv_map, does nothing if layout_version is the same as before,
+    // material ranks are reassigned if material_layout_version differs, see material_table::layout_version
+    void prepare(
+        const draw_batch_cache::shader_to_vertex_to_batch& sv_map,
+        std::size_t layout_version,
+        std::size_t material_layout_version
+    );
+
+    // is_batch_instanced is in sv_map iteration order, entities of instanced batches are not sorted individually
+    void build(
+        const ecs::layer& layer,
+        const camera_visibility& visibility,
+        const std::vector<bool>& is_batch_instanced
+    );
+
+    [[nodiscard]] std::span<const run> runs() const { return runs_; }
+    // in the order of runs, for the last build
+    [[nodiscard]] std::size_t material_change_count() const { return material_change_count_; }
+
+private:
+    struct entry {
+        std::uint64_t key;
+        std::uint32_t item; // index into items_
+    };
+    struct item {
+        entt::entity entity;
+        std::uint32_t batch_index;
+    };
+    struct batch_rank {
+        meta::unique_string shader_id;
+        meta::unique_string vertex_id;
+        std::uint32_t shader_rank;
+        std::uint32_t vertex_rank;
+    };
+
+    [[nodiscard]] std::uint32_t material_rank(meta::unique_string material_id);
+    void sort();
+
+private:
+    meta::maybe<std::size_t> layout_version_{};
+    std::vector<batch_rank> batch_ranks_;
+    meta::maybe<std::size_t> material_layout_version_{};
+    tsl::robin_map<meta::unique_string, std::uint32_t> material_ranks_;
+
+    std::vector<entry> entries_;
+    std::vector<entry> scratch_;
+    std::vector<item> items_;
+
+    std::vector<entt::entity> entities_;
+    std::vector<run> runs_;
+    std::size_t material_change_count_ = 0;
+};
+
+} // namespace sl::game
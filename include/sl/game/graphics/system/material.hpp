@@ -0,0 +1,162 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/graphics/buffer.hpp"
+#include "sl/game/graphics/component/vertex.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/gfx/vtx/texture.hpp>
+#include <sl/meta/monad/maybe.hpp>
+#include <sl/meta/storage/persistent.hpp>
+#include <sl/meta/storage/unique_string.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <tsl/robin_map.h>
+#include <tsl/robin_set.h>
+
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sl::game {
+
+// counters of material_binder, reset by graphics_system every frame
+struct material_bind_stats {
+    std::size_t material_apply_count = 0;
+    std::size_t redundant_material_apply_count = 0; // material uniforms were already set for the program
+    std::size_t texture_bind_count = 0;
+    std::size_t redundant_texture_bind_count = 0; // texture was already bound to the unit
+
+    [[nodiscard]] std::size_t redundant_bind_count() const {
+        return redundant_material_apply_count + redundant_texture_bind_count;
+    }
+};
+
+// Remembers which material uniforms and texture units are set within a frame, so that shader draws of
+// consecutive entities with the same material skip their GL calls. Entities are ordered by material by draw_queue.
+// Materials get dense handles in order of first use, which are stable for the lifetime of the binder.
+class material_binder : meta::unique {
+public:
+    using ptr_type = std::unique_ptr<material_binder>;
+
+    struct handle {
+        std::uint32_t index;
+
+        [[nodiscard]] bool operator==(const handle&) const = default;
+    };
+
+public:
+    static ptr_type make() { return ptr_type{ new material_binder{} }; }
+
+    // created on first use and kept on layer.root, so that graphics_system and all shaders share it
+    static material_binder& of(ecs::layer& layer);
+
+    [[nodiscard]] handle handle_of(meta::unique_string material_id);
+    [[nodiscard]] meta::maybe<handle> find(meta::unique_string material_id) const;
+
+    // true if uniforms of the material have to be set, false if they already are for the current program
+    [[nodiscard]] bool apply(handle a_handle);
+    // forgets the applied material, uniforms are state of a program, so it has to be called once another is bound
+    void invalidate() { applied_ = meta::null; }
+
+    // binds tex to the texture unit, unless it is already bound there
+    void bind_texture(std::uint32_t unit, const meta::persistent<texture>& tex);
+
+    // forgets everything bound, other code may have changed the state between frames
+    void begin_frame();
+    // releases texture units bound during the frame
+    void end_frame();
+
+    [[nodiscard]] const material_bind_stats& stats() const { return stats_; }
+    [[nodiscard]] std::size_t handle_count() const { return handles_.size(); }
+
+private:
+    material_binder() = default;
+
+private:
+    struct texture_unit {
+        const gfx::texture* texture = nullptr;
+        meta::maybe<gfx::bound_texture> bound{};
+    };
+
+    tsl::robin_map<meta::unique_string, handle> handles_;
+    meta::maybe<handle> applied_{};
+    std::vector<texture_unit> texture_units_;
+    material_bind_stats stats_{};
+};
+
+// material parameters for shaders which draw many materials at once, read as
+// layout(std430, binding = 6) readonly buffer b_materials { material b_materials_data[]; };
+// textures are sampled from u_material_arrays[array] at layer, see texture_arrays
+struct material_element {
+    static constexpr std::uint32_t binding = 6;
+    static constexpr std::uint32_t diffuse_texture_bit = 0b01;
+    static constexpr std::uint32_t specular_texture_bit = 0b10;
+
+    // null if some texture of the material is not packed into texture_arrays
+    [[nodiscard]] static meta::maybe<material_element> from(const material& a_material);
+
+public:
+    alignas(16) glm::vec4 diffuse_color{};
+    alignas(16) glm::vec4 specular_color{};
+    float shininess = 0.0f;
+    std::uint32_t mode = 0; // texture bits, colors are used otherwise
+    std::uint32_t diffuse_array = 0;
+    std::uint32_t diffuse_layer = 0;
+    std::uint32_t specular_array = 0;
+    std::uint32_t specular_layer = 0;
+};
+
+// material_element of every material referenced by material::id components, indexed by material_binder handles,
+// so that an instanced draw of a (shader, vertex) batch can shade every instance with its own material.
+// Materials are immutable resources, so each one is packed once. Materials which can not be packed are absent,
+// instances with them are drawn with index no_index.
+class material_table : meta::unique {
+public:
+    using ptr_type = std::unique_ptr<material_table>;
+
+    static constexpr std::uint32_t no_index = ~std::uint32_t{ 0 };
+
+public:
+    // materials of existing entities are packed by the first update
+    static ptr_type make(ecs::layer& layer) { return ptr_type{ new material_table{ layer } }; }
+
+    // created on first use and kept on layer.root, instance_element looks it up there
+    static material_table& of(ecs::layer& layer);
+
+    ~material_table();
+
+    // packs materials referenced since the last one and uploads the table if it changed, has to precede bind_base
+    void update();
+
+    [[nodiscard]] std::uint32_t index_of(meta::unique_string material_id) const;
+    [[nodiscard]] auto bind_base() & { return ssbo_.bind_base(material_element::binding); }
+    [[nodiscard]] std::size_t size() const { return elements_.size(); }
+    // changes whenever a material is packed, so that caches keyed by material ids know when to rebuild
+    [[nodiscard]] std::size_t layout_version() const { return layout_version_; }
+
+private:
+    explicit material_table(ecs::layer& layer);
+
+    void on_change(entt::registry& registry, entt::entity entity);
+
+private:
+    ecs::layer& layer_;
+    material_binder& binder_;
+
+    std::vector<meta::unique_string> marked_;
+    tsl::robin_map<meta::unique_string, std::uint32_t> index_by_id_;
+    tsl::robin_set<meta::unique_string> unpackable_;
+
+    std::vector<material_element> elements_;
+    growable_ssbo<material_element, gfx::buffer_usage::static_draw> ssbo_{};
+    bool is_dirty_ = true;
+    std::size_t layout_version_ = 0;
+};
+
+} // namespace sl::game
@@ -4,16 +4,58 @@
 
 #pragma once
 
+#include "sl/game/graphics/buffer.hpp"
 #include "sl/game/graphics/component/basis.hpp"
+#include "sl/game/graphics/component/instance.hpp"
 #include "sl/game/graphics/context.hpp"
+#include "sl/game/graphics/geometry_pool.hpp"
+#include "sl/game/graphics/system/batch.hpp"
+#include "sl/game/graphics/system/cull.hpp"
+#include "sl/game/graphics/system/draw_queue.hpp"
+#include "sl/game/graphics/system/material.hpp"
 
 #include <sl/ecs/layer.hpp>
 
+#include <sl/meta/monad/maybe.hpp>
 #include <sl/meta/monad/result.hpp>
 #include <sl/meta/type/unit.hpp>
 
+#include <memory>
+#include <span>
+#include <vector>
+
 namespace sl::game {
 
+// instance data of all instanced batches for the current frame, uploaded once and shared by all cameras
+struct instance_buffer {
+    using ring_type = ring_ssbo<instance_element>;
+
+    // recreated whenever capacity changes
+    std::unique_ptr<ring_type> ring{};
+    ssbo_capacity_policy capacity{};
+
+    // reused between frames, is_batch_instanced is in sv_map iteration order,
+    // batches and ranges are per camera, then in sv_map iteration order, only for instanced batches
+    std::vector<bool> is_batch_instanced{};
+    std::vector<std::span<const entt::entity>> batches{};
+    std::vector<instance_range> ranges{};
+    std::vector<instance_range> ranges_by_batch{}; // of the camera being drawn, in sv_map iteration order
+    fill_ssbo_chunks<instance_element> fill_chunks{};
+};
+
+// instanced batches of pooled vertices of the shader being drawn, see geometry_pool
+struct multi_draw_buffer {
+    struct pooled_batch {
+        geometry_pool_base* pool;
+        draw_elements_indirect_command command;
+    };
+
+    indirect_command_buffer indirect{};
+    // reused between shaders
+    std::vector<pooled_batch> batches{};
+    std::vector<draw_elements_indirect_command> commands{}; // of the pool being drawn
+};
+
 struct graphics_system {
     enum class error_type : std::uint8_t {
         NO_SHADER_STORAGE,
@@ -27,6 +69,16 @@ public:
 public:
     ecs::layer& layer;
     basis world;
+    worker_pool* workers = nullptr; // optional, splits culling and instance uploads of large scenes
+    draw_batch_cache::ptr_type batches = draw_batch_cache::make(layer.registry);
+    batch_handles handles{};
+    instance_buffer instances{};
+    frustum_culling culling{};
+    std::vector<camera_visibility> visibilities{}; // reused between frames, one per camera
+    draw_queue queue{};
+    material_binder& materials = material_binder::of(layer);
+    multi_draw_buffer multi_draws{};
+    draw_stats stats{}; // of the last execute
 };
 
 } // namespace sl::game
@@ -0,0 +1,115 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/engine/worker_pool.hpp"
+#include "sl/game/graphics/component/bounds.hpp"
+#include "sl/game/graphics/system/cull.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <glm/glm.hpp>
+#include <tsl/robin_map.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace sl::game {
+
+struct ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float max_distance = std::numeric_limits<float>::infinity();
+};
+
+// Bounding volume hierarchy over entities with transform and aabb (model space bounds) components.
+// Lives on layer.root, engine_context updates it after local_transform_system:
+// moved entities are observed through on_update of transform and aabb, only their leaves and ancestors are refitted,
+// the tree is rebuilt only when entities with both components are added or removed, or when refitting made it
+// too loose, so that spawning lights, cameras or group nodes does not rebuild it.
+// local_transform_system patches transforms it changes once they are observed, in-place changes elsewhere need a patch.
+// Query results are valid until the next query or update.
+class spatial_index : meta::unique {
+public:
+    using ptr_type = std::unique_ptr<spatial_index>;
+
+    static ptr_type make(entt::registry& registry) { return ptr_type{ new spatial_index{ registry } }; }
+
+    ~spatial_index();
+
+    void update(worker_pool* workers = nullptr);
+    void rebuild(worker_pool* workers = nullptr);
+
+    [[nodiscard]] std::span<const entt::entity> query(const frustum& a_frustum) &;
+    [[nodiscard]] std::span<const entt::entity> query(const bounding_sphere& sphere) &;
+    // sorted by distance to the box along the ray
+    [[nodiscard]] std::span<const entt::entity> query(const ray& a_ray) &;
+
+    [[nodiscard]] std::size_t size() const { return entities_.size(); }
+    [[nodiscard]] std::size_t refit_count() const { return refit_count_; }
+    [[nodiscard]] std::size_t rebuild_count() const { return rebuild_count_; }
+
+private:
+    explicit spatial_index(entt::registry& registry);
+
+    void on_structure_change(entt::registry&, entt::entity entity);
+    void on_box_change(entt::registry&, entt::entity entity);
+
+    void update_boxes(worker_pool* workers);
+    void update_boxes(std::span<const std::uint32_t> indices, worker_pool* workers);
+    // refits nodes of dirty boxes and their ancestors, returns the sum of node surface areas
+    [[nodiscard]] float refit();
+
+    // visits every entity whose box and all of whose ancestors' boxes satisfy overlaps
+    template <typename Overlaps, typename Visit>
+    void traverse(Overlaps&& overlaps, Visit&& visit);
+
+private:
+    using index_type = std::uint32_t;
+    static constexpr index_type leaf_size = 4;
+    static constexpr index_type npos = ~index_type{ 0 };
+
+    // children of an internal node are adjacent and placed after it, so a reverse scan refits bottom-up
+    struct bvh_node {
+        aabb box;
+        index_type first; // leaf: first entity, internal: left child, right child is first + 1
+        index_type count; // leaf: amount of entities, internal: 0
+    };
+
+    entt::registry& registry_;
+    bool is_structure_dirty_ = true;
+
+    // in leaf order
+    std::vector<entt::entity> entities_;
+    std::vector<aabb> boxes_;
+    std::vector<bvh_node> nodes_;
+    std::vector<index_type> parent_of_; // per node, npos for the root
+    std::vector<index_type> leaf_of_; // per entity
+    tsl::robin_map<entt::entity, index_type> index_by_entity_;
+
+    // changed since the last update, flags keep the lists unique
+    std::vector<index_type> dirty_boxes_;
+    std::vector<std::uint8_t> is_box_dirty_;
+    std::vector<index_type> dirty_nodes_;
+    std::vector<std::uint8_t> is_node_dirty_;
+
+    // sum of node surface areas right after the last rebuild and now
+    float built_area_ = 0.0f;
+    float area_ = 0.0f;
+
+    std::vector<index_type> stack_;
+    std::vector<std::pair<float, entt::entity>> hits_;
+    std::vector<entt::entity> result_;
+
+    std::size_t refit_count_ = 0;
+    std::size_t rebuild_count_ = 0;
+};
+
+} // namespace sl::game
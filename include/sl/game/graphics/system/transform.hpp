@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "sl/game/engine/worker_pool.hpp"
 #include "sl/game/graphics/component/transform.hpp"
 #include "sl/game/time.hpp"
 
@@ -16,6 +17,12 @@ void local_transform_system(ecs::layer& layer, entt::entity entity, time_point t
 
 } // namespace detail
 
+// recomputes transform, and world_matrix if present, of every entity under changed local_transform
 void local_transform_system(ecs::layer& layer, time_point time_point);
 
+// Same results as the serial one, but processes the tree one depth level at a time and splits every level
+// across workers. Transforms and world matrices are written in place, on_update for transforms is emitted
+// after each level and only if something listens to it, it is never emitted for world matrices.
+void local_transform_system(ecs::layer& layer, time_point time_point, worker_pool& workers);
+
 } // namespace sl::game
@@ -0,0 +1,97 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include <sl/ecs/layer.hpp>
+#include <sl/gfx/vtx/texture.hpp>
+#include <sl/meta/monad/maybe.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <glm/vec2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// location of an image packed into texture_arrays
+struct texture_layer {
+    std::uint32_t array;
+    std::uint32_t layer;
+};
+
+class texture_arrays;
+
+// Layer of texture_arrays, freed on destruction so that the next added image of the same size can reuse it.
+// Keeps texture_arrays alive, so that textures may outlive its owner on layer.root.
+class pooled_layer {
+public:
+    pooled_layer(std::shared_ptr<texture_arrays> arrays, texture_layer location)
+        : arrays_{ std::move(arrays) }, location_{ location } {}
+    pooled_layer(pooled_layer&& other) noexcept : arrays_{ std::move(other.arrays_) }, location_{ other.location_ } {}
+    pooled_layer& operator=(pooled_layer&& other) noexcept;
+    ~pooled_layer();
+
+    [[nodiscard]] const texture_layer& location() const { return location_; }
+
+private:
+    std::shared_ptr<texture_arrays> arrays_;
+    texture_layer location_;
+};
+
+// Packs RGBA8 images of equal size into one GL_TEXTURE_2D_ARRAY per distinct size, so that a single draw can sample
+// textures of many materials, see material_table. Arrays are bound to consecutive texture units and are sampled as
+// uniform sampler2DArray u_material_arrays[max_array_count];
+// Arrays grow by reallocation, layers are copied on the gpu.
+class texture_arrays : public std::enable_shared_from_this<texture_arrays>, meta::unique {
+public:
+    using ptr_type = std::shared_ptr<texture_arrays>;
+
+    static constexpr std::uint32_t max_array_count = 4;
+    static constexpr std::uint32_t initial_layer_capacity = 4;
+
+public:
+    static ptr_type make() { return ptr_type{ new texture_arrays{} }; }
+
+    // created on first use and kept on layer.root
+    static texture_arrays& of(ecs::layer& layer);
+
+    ~texture_arrays();
+
+    // null if max_array_count arrays of other sizes exist or the array has no layers left,
+    // layers freed by destroyed pooled_layer are reused before the array grows
+    [[nodiscard]] meta::maybe<pooled_layer> add(glm::uvec2 size, std::span<const std::byte> rgba) &;
+    void remove(texture_layer location) &;
+
+    // regenerates mipmaps of arrays changed since the last bind
+    void bind(std::uint32_t first_unit) &;
+
+    [[nodiscard]] std::uint32_t array_count() const { return static_cast<std::uint32_t>(arrays_.size()); }
+    // including freed layers
+    [[nodiscard]] std::uint32_t layer_count(std::uint32_t array) const { return arrays_.at(array).layer_count; }
+
+private:
+    texture_arrays() = default;
+
+private:
+    struct array {
+        glm::uvec2 size;
+        GLuint texture = 0;
+        std::uint32_t layer_count = 0;
+        std::uint32_t layer_capacity = 0;
+        std::vector<std::uint32_t> free_layers{};
+        bool is_dirty = false;
+    };
+
+    [[nodiscard]] bool reserve(array& an_array, std::uint32_t layer_capacity);
+
+private:
+    std::vector<array> arrays_;
+};
+
+} // namespace sl::game
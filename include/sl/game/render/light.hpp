@@ -4,5 +4,6 @@
 
 #pragma once
 
+#include "sl/game/render/light/cluster.hpp"
 #include "sl/game/render/light/component.hpp"
 #include "sl/game/render/light/system.hpp"
@@ -0,0 +1,138 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/engine/worker_pool.hpp"
+#include "sl/game/graphics/component/bounds.hpp"
+#include "sl/game/graphics/context.hpp"
+#include "sl/game/graphics/ssbo_mirror.hpp"
+#include "sl/game/render/light/component.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/meta/monad/maybe.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <vector>
+
+namespace sl::game::render {
+
+// view frustum split into x * y screen tiles and z exponential depth slices
+struct cluster_grid {
+    std::uint32_t x = 16;
+    std::uint32_t y = 9;
+    std::uint32_t z = 24;
+
+    [[nodiscard]] std::uint32_t size() const { return x * y * z; }
+    [[nodiscard]] std::uint32_t index(std::uint32_t a_x, std::uint32_t a_y, std::uint32_t a_z) const {
+        return a_x + x * (a_y + y * a_z);
+    }
+};
+
+// ranges of b_light_indices_data, read as uvec4
+struct light_cluster_element {
+    std::uint32_t point_offset;
+    std::uint32_t point_count;
+    std::uint32_t spot_offset;
+    std::uint32_t spot_count;
+};
+
+// Clustered forward light assignment, CPU implementation.
+// Every light is bounded by a sphere of attenuation_radius and listed in each cluster the sphere overlaps,
+// so that a fragment only shades lights of its own cluster. Buffers, indexed as in the shader:
+// layout(std430, binding = 1) readonly buffer b_point_lights { point_light b_point_lights_data[]; };
+// layout(std430, binding = 2) readonly buffer b_spot_lights { spot_light b_spot_lights_data[]; };
+// layout(std430, binding = 4) readonly buffer b_light_clusters { uvec4 b_light_clusters_data[]; };
+// layout(std430, binding = 5) readonly buffer b_light_indices { uint b_light_indices_data[]; };
+// Fragment's cluster is (ndc.xy * 0.5 + 0.5) * grid.xy and depth slice floor(log(depth / near) * depth_scale).
+class clustered_lights : meta::unique {
+public:
+    static constexpr std::uint32_t point_light_binding = 1;
+    static constexpr std::uint32_t spot_light_binding = 2;
+    static constexpr std::uint32_t cluster_binding = 4;
+    static constexpr std::uint32_t index_binding = 5;
+
+    // uniforms for the fragment shader
+    struct shader_parameters {
+        glm::uvec3 grid;
+        float near;
+        float depth_scale;
+    };
+
+public:
+    explicit clustered_lights(cluster_grid grid = {}) : grid_{ grid } {}
+
+    // lights are referenced by their index in points and spots
+    void assign(
+        std::span<const point_light_element> points,
+        std::span<const spot_light_element> spots,
+        const camera_frame& camera_frame,
+        worker_pool* workers = nullptr
+    );
+
+    // updates ssbo mirrors of point and spot lights, assigns their elements and uploads clusters
+    void upload(ecs::layer& layer, const basis& world, const camera_frame& camera_frame, worker_pool* workers);
+
+    // buffers stay bound while the result is alive, upload has to be called before
+    [[nodiscard]] auto bind_bases() & {
+        return std::tuple{
+            point_mirror_->bind_base(point_light_binding),
+            spot_mirror_->bind_base(spot_light_binding),
+            cluster_ssbo_.bind_base(cluster_binding),
+            index_ssbo_.bind_base(index_binding),
+        };
+    }
+
+    [[nodiscard]] shader_parameters parameters() const {
+        return shader_parameters{ .grid{ grid_.x, grid_.y, grid_.z }, .near = near_, .depth_scale = depth_scale_ };
+    }
+    [[nodiscard]] std::span<const light_cluster_element> clusters() const { return clusters_; }
+    [[nodiscard]] std::span<const std::uint32_t> indices() const { return indices_; }
+    [[nodiscard]] std::span<const point_light_element> points() const { return point_mirror_->elements(); }
+    [[nodiscard]] std::span<const spot_light_element> spots() const { return spot_mirror_->elements(); }
+
+private:
+    struct light_in_cluster {
+        std::uint32_t cluster;
+        std::uint32_t light; // spots follow points
+    };
+
+    void update_cluster_bounds(const glm::mat4& projection);
+    void assign_light(
+        std::vector<light_in_cluster>& out,
+        std::uint32_t light,
+        const glm::vec3& view_position,
+        float radius,
+        const glm::mat4& projection
+    ) const;
+    [[nodiscard]] std::uint32_t slice(float depth) const;
+
+private:
+    cluster_grid grid_;
+
+    // view space bounds, depend only on projection
+    meta::maybe<glm::mat4> bounds_projection_{};
+    std::vector<aabb> cluster_bounds_;
+    float near_ = 0.0f;
+    float far_ = 0.0f;
+    float depth_scale_ = 0.0f;
+
+    // shared with other shaders through layer.root, set by upload
+    ssbo_mirror<point_light_element>* point_mirror_ = nullptr;
+    ssbo_mirror<spot_light_element>* spot_mirror_ = nullptr;
+
+    std::vector<std::vector<light_in_cluster>> chunks_;
+    std::vector<light_cluster_element> clusters_;
+    std::vector<std::uint32_t> indices_;
+
+    growable_ssbo<light_cluster_element> cluster_ssbo_;
+    growable_ssbo<std::uint32_t> index_ssbo_;
+};
+
+} // namespace sl::game::render
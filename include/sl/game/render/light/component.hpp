@@ -9,6 +9,10 @@
 #include <sl/ecs/layer.hpp>
 
 #include <glm/glm.hpp>
+#include <glm/gtx/component_wise.hpp>
+
+#include <cmath>
+#include <limits>
 
 namespace sl::game::render {
 
@@ -40,6 +44,29 @@ struct spot_light {
     float outer_cutoff;
 };
 
+// distance at which 1 / (constant + linear * d + quadratic * d^2) scaled by intensity drops below threshold,
+// infinite if attenuation never gets there
+[[nodiscard]] inline float attenuation_radius(
+    float constant,
+    float linear,
+    float quadratic,
+    float intensity,
+    float threshold = 1.0f / 256.0f
+) {
+    const float limit = intensity / threshold; // attenuation denominator at the radius
+    if (constant >= limit) {
+        return 0.0f;
+    }
+    if (quadratic > 0.0f) {
+        const float discriminant = linear * linear - 4.0f * quadratic * (constant - limit);
+        return (-linear + std::sqrt(discriminant)) / (2.0f * quadratic);
+    }
+    if (linear > 0.0f) {
+        return (limit - constant) / linear;
+    }
+    return std::numeric_limits<float>::infinity();
+}
+
 struct directional_light_element {
     using component_type = directional_light;
 
@@ -95,6 +122,11 @@ public:
     float constant;
     float linear;
     float quadratic;
+
+    [[nodiscard]] float radius() const {
+        const float intensity = glm::compMax(glm::max(ambient, glm::max(diffuse, specular)));
+        return attenuation_radius(constant, linear, quadratic, intensity);
+    }
 };
 
 struct spot_light_element {
@@ -134,6 +166,12 @@ public:
     float quadratic;
     float cutoff;
     float outer_cutoff;
+
+    // of the whole sphere, cone is not taken into account
+    [[nodiscard]] float radius() const {
+        const float intensity = glm::compMax(glm::max(ambient, glm::max(diffuse, specular)));
+        return attenuation_radius(constant, linear, quadratic, intensity);
+    }
 };
 
 } // namespace sl::game::render
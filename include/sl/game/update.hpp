@@ -5,4 +5,6 @@
 #pragma once
 
 #include "sl/game/update/component.hpp"
+#include "sl/game/update/dirty.hpp"
+#include "sl/game/update/flat_tree.hpp"
 #include "sl/game/update/system.hpp"
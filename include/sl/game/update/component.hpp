@@ -10,12 +10,17 @@
 #include <sl/meta/func/function.hpp>
 
 #include <span>
+#include <utility>
+#include <vector>
 
 namespace sl::game {
 
+// Hierarchy links, parent keeps children in a vector and every child knows its index there,
+// so that detaching is a swap-and-pop. Attaching to a new parent patches the child's node, see dirty_subtrees.
 struct node {
     entt::entity parent = entt::null;
-    std::deque<entt::entity> children{}; // amortized insert/remove/iter
+    std::vector<entt::entity> children{};
+    std::size_t sibling_index = 0; // index in parent's children, meaningless without parent
 
     static void attach_child(
         ecs::layer& layer,
@@ -26,13 +31,15 @@ struct node {
     ) {
         DEBUG_ASSERT(layer.registry.try_get<node>(parent_entity) == &parent_node);
         DEBUG_ASSERT(layer.registry.try_get<node>(child_entity) == &child_node);
-        attach_child_impl(parent_entity, parent_node, child_entity, child_node);
+        connect(layer.registry);
+        attach_child_impl(layer.registry, parent_entity, parent_node, child_entity, child_node);
     }
 
     static void attach_child(ecs::layer& layer, entt::entity parent_entity, entt::entity child_entity) {
         node& parent_node = layer.registry.get_or_emplace<node>(parent_entity);
         node& child_node = layer.registry.get_or_emplace<node>(child_entity);
-        attach_child_impl(parent_entity, parent_node, child_entity, child_node);
+        connect(layer.registry);
+        attach_child_impl(layer.registry, parent_entity, parent_node, child_entity, child_node);
     }
 
     template <std::size_t children_span>
@@ -42,20 +49,100 @@ struct node {
         std::span<const entt::entity, children_span> child_entities
     ) {
         node& parent_node = layer.registry.get_or_emplace<node>(parent_entity);
+        parent_node.children.reserve(parent_node.children.size() + child_entities.size());
+        connect(layer.registry);
         for (const entt::entity child_entity : child_entities) {
             node& child_node = layer.registry.get_or_emplace<node>(child_entity);
-            attach_child_impl(parent_entity, parent_node, child_entity, child_node);
+            attach_child_impl(layer.registry, parent_entity, parent_node, child_entity, child_node);
         }
     }
 
+    // child keeps its subtree and becomes a root of it
+    static void detach_child(ecs::layer& layer, entt::entity child_entity) {
+        if (node* child_node = layer.registry.try_get<node>(child_entity); child_node != nullptr) {
+            detach_child_impl(layer.registry, child_entity, *child_node);
+        }
+    }
+
+    // moves child together with its subtree, returns false if child is an ancestor of new parent
+    static bool reparent(ecs::layer& layer, entt::entity child_entity, entt::entity parent_entity) {
+        for (entt::entity ancestor_entity = parent_entity; ancestor_entity != entt::null;) {
+            if (ancestor_entity == child_entity) {
+                return false;
+            }
+            const node* ancestor_node = layer.registry.try_get<node>(ancestor_entity);
+            ancestor_entity = ancestor_node != nullptr ? ancestor_node->parent : entt::null;
+        }
+        attach_child(layer, parent_entity, child_entity);
+        return true;
+    }
+
+    // destroys entity together with its subtree, children first, so that every parent stays valid on on_destroy
+    static void destroy(ecs::layer& layer, entt::entity entity) {
+        DEBUG_ASSERT(entity != layer.root);
+        connect(layer.registry);
+
+        std::vector<entt::entity> subtree{ entity };
+        for (std::size_t i = 0; i < subtree.size(); ++i) {
+            if (const node* a_node = layer.registry.try_get<node>(subtree[i]); a_node != nullptr) {
+                subtree.insert(subtree.end(), a_node->children.begin(), a_node->children.end());
+            }
+        }
+        for (auto r_it = subtree.rbegin(); r_it != subtree.rend(); ++r_it) {
+            layer.registry.destroy(*r_it);
+        }
+    }
+
+    // keeps parents consistent when node is removed or its entity is destroyed directly, children become roots
+    // idempotent, called by every operation above, so that plain registry.destroy is safe afterwards
+    static void connect(entt::registry& registry) { registry.on_destroy<node>().connect<&node::on_destroy>(); }
+
 private:
-    static entt::entity
-        attach_child_impl(entt::entity parent_entity, node& parent_node, entt::entity child_entity, node& child_node) {
-        entt::entity prev_parent_entity = std::exchange(child_node.parent, parent_entity);
-        if (prev_parent_entity != parent_entity) {
-            parent_node.children.push_back(child_entity);
+    static void on_destroy(entt::registry& registry, entt::entity entity) {
+        node& a_node = registry.get<node>(entity);
+        detach_child_impl(registry, entity, a_node);
+        for (const entt::entity child_entity : a_node.children) {
+            if (node* child_node = registry.try_get<node>(child_entity); child_node != nullptr) {
+                child_node->parent = entt::null;
+            }
+        }
+        a_node.children.clear();
+    }
+
+    static void attach_child_impl(
+        entt::registry& registry,
+        entt::entity parent_entity,
+        node& parent_node,
+        entt::entity child_entity,
+        node& child_node
+    ) {
+        if (child_node.parent == parent_entity) {
+            return;
+        }
+        detach_child_impl(registry, child_entity, child_node);
+        child_node.parent = parent_entity;
+        child_node.sibling_index = parent_node.children.size();
+        parent_node.children.push_back(child_entity);
+        registry.patch<node>(child_entity);
+    }
+
+    static void detach_child_impl(entt::registry& registry, entt::entity child_entity, node& child_node) {
+        const entt::entity parent_entity = std::exchange(child_node.parent, entt::null);
+        if (parent_entity == entt::null) {
+            return;
+        }
+        node* parent_node = registry.try_get<node>(parent_entity);
+        if (parent_node == nullptr) {
+            return;
+        }
+
+        auto& siblings = parent_node->children;
+        DEBUG_ASSERT(child_node.sibling_index < siblings.size() && siblings[child_node.sibling_index] == child_entity);
+        if (const entt::entity last_entity = siblings.back(); last_entity != child_entity) {
+            siblings[child_node.sibling_index] = last_entity;
+            registry.get<node>(last_entity).sibling_index = child_node.sibling_index;
         }
-        return prev_parent_entity;
+        siblings.pop_back();
     }
 };
 
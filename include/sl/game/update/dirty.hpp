@@ -0,0 +1,109 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include "sl/game/update/component.hpp"
+
+#include <sl/ecs/layer.hpp>
+#include <sl/meta/traits/unique.hpp>
+
+#include <algorithm>
+#include <concepts>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// Tracks entities whose ComponentT was emplaced or replaced/patched through registry, or which were attached to
+// a new parent, and reduces them to the minimal set of subtree roots, so that a tree update can skip unchanged
+// hierarchies. In-place changes are not observed, they need a registry.patch<ComponentT> or a mark,
+// so that a frame without changes costs nothing regardless of the size of the tree.
+template <typename ComponentT>
+class dirty_subtrees : meta::unique {
+public:
+    using ptr_type = std::unique_ptr<dirty_subtrees>;
+
+    // whole tree is considered dirty initially, since changes before creation were not observed
+    static ptr_type make(ecs::layer& layer) { return ptr_type{ new dirty_subtrees{ layer } }; }
+
+    ~dirty_subtrees() {
+        layer_.registry.template on_construct<ComponentT>().disconnect(*this);
+        layer_.registry.template on_update<ComponentT>().disconnect(*this);
+        layer_.registry.template on_update<node>().disconnect(*this);
+    }
+
+    void mark(entt::entity entity) { marked_.push_back(entity); }
+
+    // Returns roots of dirty subtrees reachable from layer.root, none of them is a descendant of another.
+    // Marked entities, which are not attached to layer.root, are dropped, attaching them marks them again.
+    // ComponentT of every root is flagged dirty, so that moved subtrees are recomputed.
+    [[nodiscard]] std::span<const entt::entity> release_roots() & {
+        roots_.clear();
+        if (marked_.empty()) {
+            return roots_;
+        }
+
+        std::ranges::sort(marked_);
+        const auto [unique_end, _] = std::ranges::unique(marked_);
+        marked_.erase(unique_end, marked_.end());
+        std::swap(marked_, pending_);
+
+        auto& registry = layer_.registry;
+        for (const entt::entity entity : pending_) {
+            if (!registry.valid(entity)) {
+                continue;
+            }
+
+            bool is_covered = false;
+            entt::entity top = entity;
+            for (const node* maybe_node = registry.template try_get<node>(top);
+                 maybe_node != nullptr && maybe_node->parent != entt::null;
+                 maybe_node = registry.template try_get<node>(top)) {
+                top = maybe_node->parent;
+                if (std::ranges::binary_search(pending_, top)) {
+                    is_covered = true;
+                    break;
+                }
+            }
+
+            if (is_covered || top != layer_.root) {
+                continue;
+            }
+            roots_.push_back(entity);
+            if constexpr (has_dirty_flag) {
+                if (auto* maybe_component = registry.template try_get<ComponentT>(entity); maybe_component != nullptr) {
+                    maybe_component->set_dirty(true);
+                }
+            }
+        }
+        pending_.clear();
+
+        return roots_;
+    }
+
+private:
+    static constexpr bool has_dirty_flag = requires(ComponentT& component) {
+        { component.is_dirty() } -> std::convertible_to<bool>;
+        component.set_dirty(true);
+    };
+
+    explicit dirty_subtrees(ecs::layer& layer) : layer_{ layer }, marked_{ layer.root } {
+        layer_.registry.template on_construct<ComponentT>().template connect<&dirty_subtrees::on_change>(*this);
+        layer_.registry.template on_update<ComponentT>().template connect<&dirty_subtrees::on_change>(*this);
+        // node is patched by node::attach_child
+        layer_.registry.template on_update<node>().template connect<&dirty_subtrees::on_change>(*this);
+    }
+
+    void on_change(entt::registry&, entt::entity entity) { mark(entity); }
+
+private:
+    ecs::layer& layer_;
+    std::vector<entt::entity> marked_;
+    std::vector<entt::entity> pending_{};
+    std::vector<entt::entity> roots_{};
+};
+
+} // namespace sl::game
@@ -0,0 +1,90 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include <sl/ecs/layer.hpp>
+#include <sl/meta/monad/maybe.hpp>
+
+#include <tsl/robin_map.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+
+// Hierarchy stored as one array in depth-first order instead of a vector of children per node,
+// so that top-down traversal is a forward scan and bottom-up traversal is a backward scan.
+// Self-contained, it does not read or write node, tree_update_system passes parents from it.
+// Structural changes patch the array in place: a subtree is moved by a rotation, only elements between its old and
+// new position are shifted, and only ancestors have their sizes adjusted. Appending under the last subtree is O(depth).
+// Detached subtrees are kept after the tree of root until they are attached again or erased.
+class flat_tree {
+public:
+    using index_type = std::uint32_t;
+    static constexpr index_type npos = ~index_type{ 0 };
+
+    // subtree of elements()[i] occupies [i, i + subtree_size), so the first child is at i + 1
+    // and the next sibling is at i + subtree_size, see first_child and next_sibling
+    struct element {
+        entt::entity entity;
+        entt::entity parent; // entt::null for root and roots of detached subtrees
+        index_type subtree_size;
+    };
+
+public:
+    explicit flat_tree(entt::entity root);
+
+    [[nodiscard]] entt::entity root() const { return elements_.front().entity; }
+    // including detached subtrees
+    [[nodiscard]] std::size_t size() const { return elements_.size(); }
+    [[nodiscard]] bool contains(entt::entity entity) const { return index_by_entity_.contains(entity); }
+    [[nodiscard]] meta::maybe<entt::entity> parent(entt::entity entity) const;
+
+    // child may be new or already in the tree, in the latter case it is moved together with its subtree,
+    // parent may be in a detached subtree as well
+    // returns false if parent is not in the tree, child is the root, or child is an ancestor of parent
+    bool attach_child(entt::entity parent_entity, entt::entity child_entity);
+
+    template <std::size_t children_span>
+    bool attach_children(entt::entity parent_entity, std::span<const entt::entity, children_span> child_entities) {
+        bool is_attached = true;
+        for (const entt::entity child_entity : child_entities) {
+            is_attached = attach_child(parent_entity, child_entity) && is_attached;
+        }
+        return is_attached;
+    }
+
+    // child keeps its subtree and becomes a root of it, same as node::detach_child, root can not be detached
+    bool detach_child(entt::entity child_entity);
+
+    // removes entity together with its subtree, root can not be erased
+    // returns amount of removed entities
+    std::size_t erase(entt::entity entity);
+
+    // tree of root only, without detached subtrees
+    [[nodiscard]] std::span<const element> elements() const& {
+        return std::span{ elements_ }.first(elements_.front().subtree_size);
+    }
+
+    // indices into elements(), npos if there is none
+    [[nodiscard]] index_type first_child(index_type index) const;
+    [[nodiscard]] index_type next_sibling(index_type index) const;
+
+private:
+    [[nodiscard]] index_type index_of(entt::entity entity) const { return index_by_entity_.at(entity); }
+
+    // adds delta to subtree_size of entity and all of its ancestors
+    void resize_subtrees(entt::entity entity, std::int64_t delta);
+    // moves [begin, end) to position to, which is outside of it, returns the new position of begin
+    index_type move(index_type begin, index_type end, index_type to);
+    void reindex(index_type begin, index_type end);
+
+private:
+    std::vector<element> elements_;
+    tsl::robin_map<entt::entity, index_type> index_by_entity_{};
+};
+
+} // namespace sl::game
@@ -5,9 +5,12 @@
 #pragma once
 
 #include "sl/game/update/component.hpp"
+#include "sl/game/update/flat_tree.hpp"
 
 #include <sl/ecs/layer.hpp>
 #include <sl/meta/assert.hpp>
+
+#include <span>
 #include <type_traits>
 #include <utility>
 
@@ -18,8 +21,13 @@ concept Update = std::is_invocable_r_v<void, F, ecs::layer&, entt::entity, time_
 
 namespace detail {
 
-void tree_update_top_down(ecs::layer& layer, Update auto an_update, time_point time_point) {
-    std::deque<entt::entity> queue{ layer.root };
+void tree_update_top_down(
+    ecs::layer& layer,
+    std::span<const entt::entity> roots,
+    Update auto an_update,
+    time_point time_point
+) {
+    std::deque<entt::entity> queue{ roots.begin(), roots.end() };
 
     while (!queue.empty()) {
         const entt::entity node_entity = queue.front();
@@ -35,8 +43,13 @@ void tree_update_top_down(ecs::layer& layer, Update auto an_update, time_point t
     }
 }
 
-void tree_update_bottom_up(ecs::layer& layer, Update auto an_update, time_point time_point) {
-    std::vector<entt::entity> tmp{ layer.root };
+void tree_update_bottom_up(
+    ecs::layer& layer,
+    std::span<const entt::entity> roots,
+    Update auto an_update,
+    time_point time_point
+) {
+    std::vector<entt::entity> tmp{ roots.begin(), roots.end() };
     std::vector<entt::entity> accum;
 
     while (!tmp.empty()) {
@@ -64,13 +77,54 @@ enum class tree_update_order {
     BOTTOM_UP, // visit children first
 };
 
+// visits only subtrees of given roots, see dirty_subtrees
+void tree_update_system(
+    tree_update_order order,
+    ecs::layer& layer,
+    std::span<const entt::entity> roots,
+    Update auto an_update,
+    time_point time_point
+) {
+    switch (order) {
+    case tree_update_order::TOP_DOWN:
+        detail::tree_update_top_down(layer, roots, std::move(an_update), time_point);
+        break;
+    case tree_update_order::BOTTOM_UP:
+        detail::tree_update_bottom_up(layer, roots, std::move(an_update), time_point);
+        break;
+    default:
+        std::unreachable();
+    }
+}
+
 void tree_update_system(tree_update_order order, ecs::layer& layer, Update auto an_update, time_point time_point) {
+    tree_update_system(order, layer, std::span{ &layer.root, 1 }, std::move(an_update), time_point);
+}
+
+// same as Update, but the parent, entt::null for root, is passed from flat_tree instead of being read from node
+template <typename F>
+concept FlatUpdate = std::is_invocable_r_v<void, F, ecs::layer&, entt::entity, entt::entity, time_point>;
+
+// linear scan of depth-first order of flat_tree, parents are visited before children on TOP_DOWN and after them on
+// BOTTOM_UP, detached subtrees of the tree are not visited
+void tree_update_system(
+    tree_update_order order,
+    ecs::layer& layer,
+    const flat_tree& tree,
+    FlatUpdate auto an_update,
+    time_point time_point
+) {
+    const std::span<const flat_tree::element> elements = tree.elements();
     switch (order) {
     case tree_update_order::TOP_DOWN:
-        detail::tree_update_top_down(layer, std::move(an_update), time_point);
+        for (const flat_tree::element& element : elements) {
+            an_update(layer, element.entity, element.parent, time_point);
+        }
         break;
     case tree_update_order::BOTTOM_UP:
-        detail::tree_update_bottom_up(layer, std::move(an_update), time_point);
+        for (auto r_it = elements.rbegin(); r_it != elements.rend(); ++r_it) {
+            an_update(layer, r_it->entity, r_it->parent, time_point);
+        }
         break;
     default:
         std::unreachable();
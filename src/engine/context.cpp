@@ -3,12 +3,16 @@
 //
 
 #include "sl/game/engine/context.hpp"
+#include "sl/game/graphics/system/spatial.hpp"
 #include "sl/game/graphics/system/transform.hpp"
 #include "sl/game/update/system.hpp"
 
 #include <sl/exec/algo/sched/start_on.hpp>
 #include <sl/exec/coro/await.hpp>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace sl::game {
 
 engine_context engine_context::initialize(window_context&& w_ctx, int argc, char** argv) {
@@ -17,6 +21,11 @@ engine_context engine_context::initialize(window_context&& w_ctx, int argc, char
     auto in_sys = std::make_unique<input_system>(*w_ctx.window);
     auto script_exec = std::make_unique<exec::manual_executor>();
     auto sync_exec = std::make_unique<exec::serial_executor<>>(*script_exec);
+    auto workers = std::make_unique<worker_pool>();
+    // loaders mostly wait for files, so they get a share of threads, not to compete with workers on frame work
+    const auto load_thread_count = static_cast<std::uint32_t>(std::max<std::size_t>(1, workers->concurrency() / 4));
+    auto load_exec =
+        std::make_unique<exec::monolithic_thread_pool>(exec::thread_pool_config{ .tcount = load_thread_count });
     return engine_context{
         .rt_ctx = std::move(rt_ctx),
         .root_path = root_path,
@@ -24,6 +33,8 @@ engine_context engine_context::initialize(window_context&& w_ctx, int argc, char
         .in_sys = std::move(in_sys),
         .script_exec = std::move(script_exec),
         .sync_exec = std::move(sync_exec),
+        .workers = std::move(workers),
+        .load_exec = std::move(load_exec),
         .t{},
         .maybe_tp{},
     };
@@ -53,7 +64,11 @@ void engine_context::spin_once(
     game::update_system(layer, time_point);
 
     // transform update
-    game::local_transform_system(layer, time_point);
+    game::local_transform_system(layer, time_point, *workers);
+    if (auto* maybe_spatial_index = layer.registry.try_get<game::spatial_index::ptr_type>(layer.root);
+        maybe_spatial_index != nullptr) {
+        (*maybe_spatial_index)->update(workers.get());
+    }
 
     // render
     const auto window_frame = w_ctx.new_frame();
@@ -0,0 +1,103 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/engine/worker_pool.hpp"
+
+#include <sl/meta/assert.hpp>
+
+namespace sl::game {
+
+worker_pool::worker_pool(std::size_t thread_count) {
+    threads_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+worker_pool::~worker_pool() {
+    {
+        std::lock_guard lock{ mutex_ };
+        is_stopped_ = true;
+    }
+    job_cv_.notify_all();
+    threads_.clear(); // joins
+}
+
+std::size_t worker_pool::default_thread_count() {
+    const std::size_t hardware_concurrency = std::thread::hardware_concurrency();
+    return hardware_concurrency > 1 ? hardware_concurrency - 1 : 0;
+}
+
+void worker_pool::run(std::size_t size, std::size_t grain, void* f_ptr, invoke_type invoke) {
+    const std::size_t a_chunk_count = chunk_count(size, grain);
+    if (a_chunk_count == 0) {
+        return;
+    }
+    if (a_chunk_count == 1 || threads_.empty()) {
+        for (std::size_t chunk_index = 0; chunk_index < a_chunk_count; ++chunk_index) {
+            const std::size_t begin = chunk_index * grain;
+            invoke(f_ptr, chunk_index, begin, std::min(size, begin + grain));
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock{ mutex_ };
+        DEBUG_ASSERT(!is_job_active_, "parallel_for is not reentrant");
+        job_ = job{
+            .size = size,
+            .grain = grain,
+            .chunk_count = a_chunk_count,
+            .f_ptr = f_ptr,
+            .invoke = invoke,
+        };
+        next_chunk_.store(0, std::memory_order_relaxed);
+        is_job_active_ = true;
+        ++generation_;
+    }
+    job_cv_.notify_all();
+
+    execute_chunks();
+
+    // every chunk is claimed at this point, wait for the ones still executing on workers
+    std::unique_lock lock{ mutex_ };
+    done_cv_.wait(lock, [this] { return active_ == 0; });
+    is_job_active_ = false;
+}
+
+void worker_pool::execute_chunks() {
+    // job_ is not modified while there is an active job
+    const job& a_job = job_;
+    for (std::size_t chunk_index = next_chunk_.fetch_add(1, std::memory_order_relaxed);
+         chunk_index < a_job.chunk_count;
+         chunk_index = next_chunk_.fetch_add(1, std::memory_order_relaxed)) {
+        const std::size_t begin = chunk_index * a_job.grain;
+        a_job.invoke(a_job.f_ptr, chunk_index, begin, std::min(a_job.size, begin + a_job.grain));
+    }
+}
+
+void worker_pool::worker_loop() {
+    std::uint64_t seen_generation = 0;
+    std::unique_lock lock{ mutex_ };
+    while (true) {
+        job_cv_.wait(lock, [this, &seen_generation] {
+            return is_stopped_ || (is_job_active_ && generation_ != seen_generation);
+        });
+        if (is_stopped_) {
+            return;
+        }
+        seen_generation = generation_;
+        ++active_;
+
+        lock.unlock();
+        execute_chunks();
+        lock.lock();
+
+        if (--active_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+} // namespace sl::game
@@ -0,0 +1,34 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/component/instance.hpp"
+#include "sl/game/graphics/system/material.hpp"
+
+namespace sl::game {
+
+meta::maybe<instance_element> instance_element::from(
+    const ecs::layer& layer,
+    const basis&,
+    entt::entity entity,
+    const component_type& component
+) {
+    std::uint32_t material_index = material_table::no_index;
+    if (const auto* maybe_table = layer.registry.try_get<material_table::ptr_type>(layer.root);
+        maybe_table != nullptr) {
+        if (const auto* maybe_mat_id = layer.registry.try_get<material::id>(entity); maybe_mat_id != nullptr) {
+            material_index = (*maybe_table)->index_of(maybe_mat_id->id);
+        }
+    }
+
+    // cached by local_transform_system for entities that have it
+    const auto* maybe_matrix = layer.registry.try_get<world_matrix>(entity);
+    const world_matrix matrix = maybe_matrix != nullptr ? *maybe_matrix : world_matrix::from(component);
+    return instance_element{
+        .model = matrix.model,
+        .it_model = glm::mat4{ matrix.normal },
+        .material_index = material_index,
+    };
+}
+
+} // namespace sl::game
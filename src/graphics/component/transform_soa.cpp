@@ -0,0 +1,113 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/component/transform_soa.hpp"
+
+#include "transform_soa_kernel.hpp"
+
+#include <sl/meta/assert.hpp>
+
+#include <initializer_list>
+
+namespace sl::game {
+namespace {
+
+// SL_GAME_TRANSFORM_SOA_AVX2 is defined when transform_soa_avx2.cpp is built, the cpu is checked once
+bool is_avx2_supported() {
+#if defined(SL_GAME_TRANSFORM_SOA_AVX2)
+    static const bool is_supported = __builtin_cpu_supports("avx2");
+    return is_supported;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+void transform_soa::resize(std::size_t size) {
+    for (std::vector<float>* component : { &tr_x, &tr_y, &tr_z, &rot_x, &rot_y, &rot_z, &rot_w, &s_x, &s_y, &s_z }) {
+        component->resize(size);
+    }
+}
+
+void transform_soa::push_back(const transform& tf) {
+    resize(size() + 1);
+    set(size() - 1, tf);
+}
+
+void transform_soa::set(std::size_t i, const transform& tf) {
+    tr_x[i] = tf.tr.x;
+    tr_y[i] = tf.tr.y;
+    tr_z[i] = tf.tr.z;
+    rot_x[i] = tf.rot.x;
+    rot_y[i] = tf.rot.y;
+    rot_z[i] = tf.rot.z;
+    rot_w[i] = tf.rot.w;
+    s_x[i] = tf.s.x;
+    s_y[i] = tf.s.y;
+    s_z[i] = tf.s.z;
+}
+
+transform transform_soa::get(std::size_t i) const {
+    return transform{
+        .tr{ tr_x[i], tr_y[i], tr_z[i] },
+        .rot{ rot_w[i], rot_x[i], rot_y[i], rot_z[i] },
+        .s{ s_x[i], s_y[i], s_z[i] },
+    };
+}
+
+void combine(const transform_soa& parent, const transform_soa& local, transform_soa& out, std::span<glm::mat4> models) {
+    combine(parent, local, out, models, combine_lane_count());
+}
+
+void combine(
+    const transform_soa& parent,
+    const transform_soa& local,
+    transform_soa& out,
+    std::span<glm::mat4> models,
+    std::size_t max_lane_count
+) {
+    const std::size_t size = parent.size();
+    ASSERT(local.size() == size, "parent and local have to be of the same size", size, local.size());
+    ASSERT(models.empty() || models.size() >= size, "not enough space for models", size, models.size());
+    out.resize(size);
+    if (size == 0) {
+        return;
+    }
+
+    const detail::combine_arguments args{
+        .parent{ parent.tr_x.data(), parent.tr_y.data(), parent.tr_z.data(), parent.rot_x.data(), parent.rot_y.data(),
+                 parent.rot_z.data(), parent.rot_w.data(), parent.s_x.data(), parent.s_y.data(), parent.s_z.data() },
+        .local{ local.tr_x.data(), local.tr_y.data(), local.tr_z.data(), local.rot_x.data(), local.rot_y.data(),
+                local.rot_z.data(), local.rot_w.data(), local.s_x.data(), local.s_y.data(), local.s_z.data() },
+        .out{ out.tr_x.data(), out.tr_y.data(), out.tr_z.data(), out.rot_x.data(), out.rot_y.data(),
+              out.rot_z.data(), out.rot_w.data(), out.s_x.data(), out.s_y.data(), out.s_z.data() },
+        .models = models.empty() ? nullptr : &models.front()[0][0],
+    };
+
+    std::size_t i = 0;
+    if (max_lane_count >= 8 && is_avx2_supported()) {
+        i = detail::combine_avx2(args, i, size);
+    }
+#if defined(SL_GAME_TRANSFORM_SOA_SSE2)
+    if (max_lane_count >= 4) {
+        i = detail::combine_lanes<detail::f32x4>(args, i, size);
+    }
+#endif
+    i = detail::combine_lanes<detail::f32x1>(args, i, size);
+    DEBUG_ASSERT(i == size);
+}
+
+std::size_t combine_lane_count() {
+    if (is_avx2_supported()) {
+        return 8;
+    }
+#if defined(SL_GAME_TRANSFORM_SOA_SSE2)
+    return 4;
+#else
+    return 1;
+#endif
+}
+
+} // namespace sl::game
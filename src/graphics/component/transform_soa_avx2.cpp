@@ -0,0 +1,13 @@
+//
+// Created by usatiynyan.
+//
+
+#include "transform_soa_kernel.hpp"
+
+namespace sl::game::detail {
+
+std::size_t combine_avx2(const combine_arguments& args, std::size_t begin, std::size_t end) {
+    return combine_lanes<f32x8>(args, begin, end);
+}
+
+} // namespace sl::game::detail
@@ -0,0 +1,168 @@
+//
+// Created by usatiynyan.
+//
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SL_GAME_TRANSFORM_SOA_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace sl::game::detail {
+
+// components of transform_soa in its order: tr xyz, rot xyzw, s xyz
+inline constexpr std::size_t transform_component_count = 10;
+
+// Raw pointers only, so that no inline function of glm or std is shared between translation units compiled for
+// different instruction sets, the linker could otherwise pick the AVX2 copy of it for every caller.
+struct combine_arguments {
+    const float* parent[transform_component_count];
+    const float* local[transform_component_count];
+    float* out[transform_component_count];
+    float* models; // column-major 4x4 per element, null if not requested
+};
+
+// compiled with -mavx2 in transform_soa_avx2.cpp and called only if the cpu supports it, returns where it stopped
+std::size_t combine_avx2(const combine_arguments& args, std::size_t begin, std::size_t end);
+
+// internal linkage, so that every translation unit keeps the kernels compiled for its own instruction set
+namespace {
+
+// every lane type provides the same minimal interface, so that one kernel is instantiated per instruction set
+
+struct f32x1 {
+    static constexpr std::size_t width = 1;
+    float v;
+
+    static f32x1 load(const float* ptr) { return { *ptr }; }
+    static f32x1 broadcast(float x) { return { x }; }
+    void store(float* ptr) const { *ptr = v; }
+
+    friend f32x1 operator+(f32x1 a, f32x1 b) { return { a.v + b.v }; }
+    friend f32x1 operator-(f32x1 a, f32x1 b) { return { a.v - b.v }; }
+    friend f32x1 operator*(f32x1 a, f32x1 b) { return { a.v * b.v }; }
+};
+
+#if defined(SL_GAME_TRANSFORM_SOA_SSE2)
+struct f32x4 {
+    static constexpr std::size_t width = 4;
+    __m128 v;
+
+    static f32x4 load(const float* ptr) { return { _mm_loadu_ps(ptr) }; }
+    static f32x4 broadcast(float x) { return { _mm_set1_ps(x) }; }
+    void store(float* ptr) const { _mm_storeu_ps(ptr, v); }
+
+    friend f32x4 operator+(f32x4 a, f32x4 b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend f32x4 operator-(f32x4 a, f32x4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend f32x4 operator*(f32x4 a, f32x4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+};
+#endif
+
+#if defined(__AVX2__)
+struct f32x8 {
+    static constexpr std::size_t width = 8;
+    __m256 v;
+
+    static f32x8 load(const float* ptr) { return { _mm256_loadu_ps(ptr) }; }
+    static f32x8 broadcast(float x) { return { _mm256_set1_ps(x) }; }
+    void store(float* ptr) const { _mm256_storeu_ps(ptr, v); }
+
+    friend f32x8 operator+(f32x8 a, f32x8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+    friend f32x8 operator-(f32x8 a, f32x8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    friend f32x8 operator*(f32x8 a, f32x8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+};
+#endif
+
+// processes [begin, end) in steps of V::width while a whole step fits, returns where it stopped
+template <typename V>
+std::size_t combine_lanes(const combine_arguments& args, std::size_t begin, std::size_t end) {
+    const V one = V::broadcast(1.0f);
+    const V two = V::broadcast(2.0f);
+    const float* const* const parent = args.parent;
+    const float* const* const local = args.local;
+    float* const* const out = args.out;
+
+    std::size_t i = begin;
+    for (; i + V::width <= end; i += V::width) {
+        // a = parent, b = local, see combine(const transform&, const transform&)
+        const V a_tr_x = V::load(parent[0] + i), a_tr_y = V::load(parent[1] + i), a_tr_z = V::load(parent[2] + i);
+        const V a_x = V::load(parent[3] + i), a_y = V::load(parent[4] + i);
+        const V a_z = V::load(parent[5] + i), a_w = V::load(parent[6] + i);
+        const V a_s_x = V::load(parent[7] + i), a_s_y = V::load(parent[8] + i), a_s_z = V::load(parent[9] + i);
+
+        const V b_tr_x = V::load(local[0] + i), b_tr_y = V::load(local[1] + i), b_tr_z = V::load(local[2] + i);
+        const V b_x = V::load(local[3] + i), b_y = V::load(local[4] + i);
+        const V b_z = V::load(local[5] + i), b_w = V::load(local[6] + i);
+        const V b_s_x = V::load(local[7] + i), b_s_y = V::load(local[8] + i), b_s_z = V::load(local[9] + i);
+
+        // tr = b.rot * a.tr + b.tr, where q * v = v + w * t + cross(q.xyz, t), t = 2 * cross(q.xyz, v)
+        const V t_x = two * (b_y * a_tr_z - b_z * a_tr_y);
+        const V t_y = two * (b_z * a_tr_x - b_x * a_tr_z);
+        const V t_z = two * (b_x * a_tr_y - b_y * a_tr_x);
+        const V tr_x = a_tr_x + b_w * t_x + (b_y * t_z - b_z * t_y) + b_tr_x;
+        const V tr_y = a_tr_y + b_w * t_y + (b_z * t_x - b_x * t_z) + b_tr_y;
+        const V tr_z = a_tr_z + b_w * t_z + (b_x * t_y - b_y * t_x) + b_tr_z;
+
+        // rot = b.rot * a.rot
+        const V x = b_w * a_x + b_x * a_w + b_y * a_z - b_z * a_y;
+        const V y = b_w * a_y + b_y * a_w + b_z * a_x - b_x * a_z;
+        const V z = b_w * a_z + b_z * a_w + b_x * a_y - b_y * a_x;
+        const V w = b_w * a_w - b_x * a_x - b_y * a_y - b_z * a_z;
+
+        // s = b.s * a.s
+        const V s_x = b_s_x * a_s_x;
+        const V s_y = b_s_y * a_s_y;
+        const V s_z = b_s_z * a_s_z;
+
+        tr_x.store(out[0] + i);
+        tr_y.store(out[1] + i);
+        tr_z.store(out[2] + i);
+        x.store(out[3] + i);
+        y.store(out[4] + i);
+        z.store(out[5] + i);
+        w.store(out[6] + i);
+        s_x.store(out[7] + i);
+        s_y.store(out[8] + i);
+        s_z.store(out[9] + i);
+
+        if (args.models == nullptr) {
+            continue;
+        }
+
+        // translate * mat4_cast(rot) * scale, computed per component and transposed into matrices per lane
+        const V xx = x * x, yy = y * y, zz = z * z;
+        const V xy = x * y, xz = x * z, yz = y * z;
+        const V wx = w * x, wy = w * y, wz = w * z;
+
+        const V columns[12]{
+            (one - two * (yy + zz)) * s_x, two * (xy + wz) * s_x, two * (xz - wy) * s_x, //
+            two * (xy - wz) * s_y, (one - two * (xx + zz)) * s_y, two * (yz + wx) * s_y, //
+            two * (xz + wy) * s_z, two * (yz - wx) * s_z, (one - two * (xx + yy)) * s_z, //
+            tr_x, tr_y, tr_z,
+        };
+        float lanes[12][V::width];
+        for (std::size_t c = 0; c < 12; ++c) {
+            columns[c].store(lanes[c]);
+        }
+        for (std::size_t lane = 0; lane < V::width; ++lane) {
+            float* const model = args.models + (i + lane) * 16;
+            for (std::size_t column = 0; column < 4; ++column) {
+                for (std::size_t row = 0; row < 3; ++row) {
+                    model[column * 4 + row] = lanes[column * 3 + row][lane];
+                }
+                model[column * 4 + 3] = column == 3 ? 1.0f : 0.0f;
+            }
+        }
+    }
+    return i;
+}
+
+} // namespace
+} // namespace sl::game::detail
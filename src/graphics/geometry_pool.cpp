@@ -0,0 +1,383 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/geometry_pool.hpp"
+#include "sl/game/detail/log.hpp"
+
+#include <sl/meta/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+namespace sl::game {
+namespace {
+
+const void* index_offset(const geometry_range& range) {
+    return reinterpret_cast<const void*>(std::uintptr_t{ range.first_index } * sizeof(geometry_pool_base::index_type));
+}
+
+} // namespace
+
+pooled_geometry& pooled_geometry::operator=(pooled_geometry&& other) noexcept {
+    if (this != &other) {
+        if (pool_ != nullptr) {
+            pool_->free(slot_);
+        }
+        pool_ = std::move(other.pool_);
+        slot_ = other.slot_;
+    }
+    return *this;
+}
+
+pooled_geometry::~pooled_geometry() {
+    if (pool_ != nullptr) {
+        pool_->free(slot_);
+    }
+}
+
+geometry_range pooled_geometry::range() const { return pool_->range(slot_); }
+
+meta::maybe<std::uint32_t> geometry_free_list::acquire(std::uint32_t count) {
+    if (count == 0) {
+        return 0u;
+    }
+    const auto it = std::ranges::find_if(blocks_, [count](const auto& block) { return block.second >= count; });
+    if (it == blocks_.end()) {
+        return meta::null;
+    }
+    const auto [offset, block_count] = *it;
+    blocks_.erase(it);
+    if (block_count > count) {
+        blocks_.emplace(offset + count, block_count - count);
+    }
+    return offset;
+}
+
+void geometry_free_list::release(std::uint32_t offset, std::uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+    auto next_it = blocks_.lower_bound(offset);
+    ASSERT(next_it == blocks_.end() || offset + count <= next_it->first, "double release", offset, count);
+    if (next_it != blocks_.end() && offset + count == next_it->first) {
+        count += next_it->second;
+        next_it = blocks_.erase(next_it);
+    }
+    if (next_it != blocks_.begin()) {
+        const auto prev_it = std::prev(next_it);
+        ASSERT(prev_it->first + prev_it->second <= offset, "double release", offset, count);
+        if (prev_it->first + prev_it->second == offset) {
+            prev_it->second += count;
+            return;
+        }
+    }
+    blocks_.emplace_hint(next_it, offset, count);
+}
+
+std::uint32_t geometry_free_list::trim(std::uint32_t size) {
+    if (blocks_.empty()) {
+        return size;
+    }
+    const auto last_it = std::prev(blocks_.end());
+    if (last_it->first + last_it->second != size) {
+        return size;
+    }
+    const std::uint32_t trimmed_size = last_it->first;
+    blocks_.erase(last_it);
+    return trimmed_size;
+}
+
+std::uint32_t geometry_free_list::largest_block() const {
+    std::uint32_t largest = 0;
+    for (const auto& [offset, count] : blocks_) {
+        largest = std::max(largest, count);
+    }
+    return largest;
+}
+
+gfx::vertex_array& geometry_pool_base::va() & {
+    if (is_dirty_ || !va_.has_value()) {
+        is_dirty_ = false;
+        const auto exceeds_threshold = [](std::uint32_t used, std::uint32_t size) {
+            return static_cast<float>(size - used) > compact_threshold * static_cast<float>(size);
+        };
+        // buffers are reuploaded anyway, so moving geometry costs only the cpu copy,
+        // which is bounded per call, the pool stays dirty until it is compact enough or nothing can be moved
+        if (exceeds_threshold(vertex_used_, vertex_size_) || exceeds_threshold(index_used_, index_size_)) {
+            const std::uint32_t moved_count = compact_tail(storage::vertices, compact_step_size)
+                                              + compact_tail(storage::indices, compact_step_size);
+            is_dirty_ = moved_count > 0
+                        && (exceeds_threshold(vertex_used_, vertex_size_)
+                            || exceeds_threshold(index_used_, index_size_));
+        }
+        rebuild();
+        ++rebuild_count_;
+        log::trace(
+            "[geometry_pool] vertices={}/{} indices={}/{} allocations={}",
+            vertex_used_,
+            vertex_size_,
+            index_used_,
+            index_size_,
+            allocations_.size() - free_slots_.size()
+        );
+    }
+    return va_.value();
+}
+
+vertex geometry_pool_base::vertex_of(pooled_geometry allocation, meta::maybe<aabb> bounds) & {
+    ASSERT(&allocation.pool() == this);
+    const std::uint32_t slot = allocation.slot();
+    // range is looked up on every draw, since compaction moves it
+    return vertex{
+        .va = std::move(allocation),
+        .draw{ [pool = this, slot](gfx::draw&) {
+            const geometry_range range = pool->range(slot);
+            glDrawElementsBaseVertex(
+                GL_TRIANGLES,
+                static_cast<GLsizei>(range.index_count),
+                index_gl_type,
+                index_offset(range),
+                range.base_vertex
+            );
+        } },
+        .draw_instanced{ [pool = this, slot](gfx::draw&, std::uint32_t base_instance, std::uint32_t instance_count) {
+            const geometry_range range = pool->range(slot);
+            glDrawElementsInstancedBaseVertexBaseInstance(
+                GL_TRIANGLES,
+                static_cast<GLsizei>(range.index_count),
+                index_gl_type,
+                index_offset(range),
+                static_cast<GLsizei>(instance_count),
+                range.base_vertex,
+                base_instance
+            );
+        } },
+        .bounds = std::move(bounds),
+    };
+}
+
+geometry_range geometry_pool_base::range(std::uint32_t slot) const {
+    const allocation& an_allocation = allocations_[slot];
+    return geometry_range{
+        .first_index = an_allocation.index_offset,
+        .index_count = an_allocation.index_count,
+        .base_vertex = static_cast<std::int32_t>(an_allocation.vertex_offset),
+    };
+}
+
+std::uint32_t geometry_pool_base::allocate(std::uint32_t vertex_count, std::uint32_t index_count) {
+    // grows the storage, the free block at its end, if any, becomes a part of the allocation
+    const auto acquire = [](geometry_free_list& free_list, std::uint32_t& size, std::uint32_t count) {
+        if (auto maybe_offset = free_list.acquire(count); maybe_offset.has_value()) {
+            return maybe_offset.value();
+        }
+        size = free_list.trim(size);
+        return std::exchange(size, size + count);
+    };
+    const std::uint32_t prev_vertex_size = vertex_size_;
+    const std::uint32_t prev_index_size = index_size_;
+    const allocation an_allocation{
+        .vertex_offset = acquire(vertex_free_list_, vertex_size_, vertex_count),
+        .vertex_count = vertex_count,
+        .index_offset = acquire(index_free_list_, index_size_, index_count),
+        .index_count = index_count,
+        .is_live = true,
+    };
+    if (vertex_size_ != prev_vertex_size || index_size_ != prev_index_size) {
+        resize(vertex_size_, index_size_);
+    }
+    vertex_used_ += vertex_count;
+    index_used_ += index_count;
+    is_dirty_ = true;
+
+    if (!free_slots_.empty()) {
+        const std::uint32_t slot = free_slots_.back();
+        free_slots_.pop_back();
+        allocations_[slot] = an_allocation;
+        return slot;
+    }
+    allocations_.push_back(an_allocation);
+    return static_cast<std::uint32_t>(allocations_.size() - 1);
+}
+
+void geometry_pool_base::free(std::uint32_t slot) & {
+    allocation& an_allocation = allocations_[slot];
+    ASSERT(an_allocation.is_live, "double free", slot);
+    an_allocation.is_live = false;
+    free_slots_.push_back(slot);
+
+    vertex_free_list_.release(an_allocation.vertex_offset, an_allocation.vertex_count);
+    index_free_list_.release(an_allocation.index_offset, an_allocation.index_count);
+    vertex_used_ -= an_allocation.vertex_count;
+    index_used_ -= an_allocation.index_count;
+
+    // storage does not keep free blocks at its end
+    const std::uint32_t vertex_size = vertex_free_list_.trim(vertex_size_);
+    const std::uint32_t index_size = index_free_list_.trim(index_size_);
+    if (vertex_size != vertex_size_ || index_size != index_size_) {
+        vertex_size_ = vertex_size;
+        index_size_ = index_size;
+        resize(vertex_size_, index_size_);
+    }
+    is_dirty_ = true;
+}
+
+void geometry_pool_base::compact() & {
+    std::vector<std::uint32_t> live_slots;
+    live_slots.reserve(allocations_.size() - free_slots_.size());
+    for (std::uint32_t slot = 0; slot < allocations_.size(); ++slot) {
+        if (allocations_[slot].is_live) {
+            live_slots.push_back(slot);
+        }
+    }
+
+    // in the order of offsets, so that each destination is before its source and never overwrites live geometry
+    std::ranges::sort(live_slots, std::less{}, [this](std::uint32_t slot) { return allocations_[slot].vertex_offset; });
+    std::uint32_t vertex_offset = 0;
+    for (const std::uint32_t slot : live_slots) {
+        allocation& an_allocation = allocations_[slot];
+        if (an_allocation.vertex_offset != vertex_offset) {
+            move_vertices(an_allocation.vertex_offset, vertex_offset, an_allocation.vertex_count);
+            an_allocation.vertex_offset = vertex_offset;
+        }
+        vertex_offset += an_allocation.vertex_count;
+    }
+
+    std::ranges::sort(live_slots, std::less{}, [this](std::uint32_t slot) { return allocations_[slot].index_offset; });
+    std::uint32_t index_offset = 0;
+    for (const std::uint32_t slot : live_slots) {
+        allocation& an_allocation = allocations_[slot];
+        if (an_allocation.index_offset != index_offset) {
+            move_indices(an_allocation.index_offset, index_offset, an_allocation.index_count);
+            an_allocation.index_offset = index_offset;
+        }
+        index_offset += an_allocation.index_count;
+    }
+
+    log::debug(
+        "[geometry_pool] compacted vertices={}->{} indices={}->{}",
+        vertex_size_,
+        vertex_offset,
+        index_size_,
+        index_offset
+    );
+    vertex_free_list_.clear();
+    index_free_list_.clear();
+    vertex_size_ = vertex_offset;
+    index_size_ = index_offset;
+    resize(vertex_size_, index_size_);
+    ++compaction_count_;
+    is_dirty_ = true;
+}
+
+std::uint32_t geometry_pool_base::compact_tail(storage a_storage, std::uint32_t max_count) {
+    const bool is_vertex = a_storage == storage::vertices;
+    geometry_free_list& free_list = is_vertex ? vertex_free_list_ : index_free_list_;
+    const auto offset_of = [is_vertex](allocation& an_allocation) -> std::uint32_t& {
+        return is_vertex ? an_allocation.vertex_offset : an_allocation.index_offset;
+    };
+    const auto count_of = [is_vertex](const allocation& an_allocation) {
+        return is_vertex ? an_allocation.vertex_count : an_allocation.index_count;
+    };
+
+    tail_slots_.clear();
+    for (std::uint32_t slot = 0; slot < allocations_.size(); ++slot) {
+        if (allocations_[slot].is_live && count_of(allocations_[slot]) > 0) {
+            tail_slots_.push_back(slot);
+        }
+    }
+    std::ranges::sort(tail_slots_, std::greater{}, [&](std::uint32_t slot) { return offset_of(allocations_[slot]); });
+
+    std::uint32_t moved_count = 0;
+    for (const std::uint32_t slot : tail_slots_) {
+        if (moved_count >= max_count) {
+            break;
+        }
+        allocation& an_allocation = allocations_[slot];
+        const std::uint32_t count = count_of(an_allocation);
+        const auto maybe_to = free_list.acquire(count);
+        if (!maybe_to.has_value()) {
+            continue;
+        }
+        const std::uint32_t to = maybe_to.value();
+        // first fit is the lowest block, if it is after the allocation, moving it would not compact anything
+        if (to > offset_of(an_allocation)) {
+            free_list.release(to, count);
+            continue;
+        }
+        if (is_vertex) {
+            move_vertices(offset_of(an_allocation), to, count);
+        } else {
+            move_indices(offset_of(an_allocation), to, count);
+        }
+        free_list.release(std::exchange(offset_of(an_allocation), to), count);
+        moved_count += count;
+    }
+    if (moved_count == 0) {
+        return 0;
+    }
+
+    const std::uint32_t vertex_size = vertex_free_list_.trim(vertex_size_);
+    const std::uint32_t index_size = index_free_list_.trim(index_size_);
+    if (vertex_size != vertex_size_ || index_size != index_size_) {
+        vertex_size_ = vertex_size;
+        index_size_ = index_size;
+        resize(vertex_size_, index_size_);
+    }
+    log::debug(
+        "[geometry_pool] compacted tail of {} moved={} size={}",
+        is_vertex ? "vertices" : "indices",
+        moved_count,
+        is_vertex ? vertex_size_ : index_size_
+    );
+    ++compaction_count_;
+    return moved_count;
+}
+
+geometry_pool_stats geometry_pool_base::stats() const {
+    return geometry_pool_stats{
+        .vertices{
+            .used = vertex_used_,
+            .size = vertex_size_,
+            .free_block_count = vertex_free_list_.block_count(),
+            .largest_free_block = vertex_free_list_.largest_block(),
+        },
+        .indices{
+            .used = index_used_,
+            .size = index_size_,
+            .free_block_count = index_free_list_.block_count(),
+            .largest_free_block = index_free_list_.largest_block(),
+        },
+        .allocation_count = allocations_.size() - free_slots_.size(),
+        .compaction_count = compaction_count_,
+        .rebuild_count = rebuild_count_,
+    };
+}
+
+indirect_command_buffer::~indirect_command_buffer() {
+    if (buffer_ != 0) {
+        glDeleteBuffers(1, &buffer_);
+    }
+}
+
+void indirect_command_buffer::multi_draw(std::span<const draw_elements_indirect_command> commands) & {
+    if (commands.empty()) {
+        return;
+    }
+    if (buffer_ == 0) {
+        glCreateBuffers(1, &buffer_);
+    }
+    // orphans the storage of the previous draw, which the gpu may still read
+    glNamedBufferData(buffer_, static_cast<GLsizeiptr>(commands.size_bytes()), commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer_);
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, geometry_pool_base::index_gl_type, nullptr, static_cast<GLsizei>(commands.size()), 0
+    );
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+} // namespace sl::game
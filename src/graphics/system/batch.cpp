@@ -0,0 +1,147 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/batch.hpp"
+#include "sl/game/graphics/component/vertex.hpp"
+
+#include <sl/meta/assert.hpp>
+
+#include <algorithm>
+
+namespace sl::game {
+
+draw_batch_cache::draw_batch_cache(entt::registry& registry) : registry_{ registry } {
+    registry_.on_construct<shader::id>().connect<&draw_batch_cache::on_construct>(*this);
+    registry_.on_construct<vertex::id>().connect<&draw_batch_cache::on_construct>(*this);
+    registry_.on_update<shader::id>().connect<&draw_batch_cache::on_update>(*this);
+    registry_.on_update<vertex::id>().connect<&draw_batch_cache::on_update>(*this);
+    registry_.on_destroy<shader::id>().connect<&draw_batch_cache::on_destroy>(*this);
+    registry_.on_destroy<vertex::id>().connect<&draw_batch_cache::on_destroy>(*this);
+
+    const auto entities = registry_.view<shader::id, vertex::id>();
+    for (const auto& [entity, shader, vertex] : entities.each()) {
+        insert(entity, shader.id, vertex.id);
+    }
+}
+
+draw_batch_cache::~draw_batch_cache() {
+    registry_.on_construct<shader::id>().disconnect(*this);
+    registry_.on_construct<vertex::id>().disconnect(*this);
+    registry_.on_update<shader::id>().disconnect(*this);
+    registry_.on_update<vertex::id>().disconnect(*this);
+    registry_.on_destroy<shader::id>().disconnect(*this);
+    registry_.on_destroy<vertex::id>().disconnect(*this);
+}
+
+const draw_batch_cache::shader_to_vertex_to_batch& draw_batch_cache::prepare() & {
+    if (!std::exchange(is_dirty_, false)) {
+        return sv_map_;
+    }
+
+    for (auto sv_it = sv_map_.begin(); sv_it != sv_map_.end();) {
+        vertex_to_batch& v_map = sv_it.value();
+        for (auto v_it = v_map.begin(); v_it != v_map.end();) {
+            batch& a_batch = v_it.value();
+            if (a_batch.entities.empty()) {
+                v_it = v_map.erase(v_it);
+                ++layout_version_;
+                continue;
+            }
+            if (!std::exchange(a_batch.is_sorted, true)) {
+                std::ranges::sort(a_batch.entities);
+                for (std::size_t index = 0; index < a_batch.entities.size(); ++index) {
+                    const auto key_it = key_by_entity_.find(a_batch.entities[index]);
+                    ASSERT(key_it != key_by_entity_.end());
+                    key_it.value().index = index;
+                }
+            }
+            ++v_it;
+        }
+
+        if (v_map.empty()) {
+            sv_it = sv_map_.erase(sv_it);
+        } else {
+            ++sv_it;
+        }
+    }
+
+    return sv_map_;
+}
+
+void draw_batch_cache::on_construct(entt::registry& registry, entt::entity entity) {
+    const auto [maybe_shader_id, maybe_vertex_id] = registry.try_get<shader::id, vertex::id>(entity);
+    if (maybe_shader_id == nullptr || maybe_vertex_id == nullptr) {
+        return;
+    }
+    insert(entity, maybe_shader_id->id, maybe_vertex_id->id);
+}
+
+void draw_batch_cache::on_update(entt::registry& registry, entt::entity entity) {
+    erase(entity);
+    on_construct(registry, entity);
+}
+
+void draw_batch_cache::on_destroy(entt::registry&, entt::entity entity) { erase(entity); }
+
+void draw_batch_cache::insert(entt::entity entity, meta::unique_string shader_id, meta::unique_string vertex_id) {
+    vertex_to_batch& v_map = sv_map_[shader_id];
+    const std::size_t batch_count = v_map.size();
+    batch& a_batch = v_map[vertex_id];
+    if (v_map.size() != batch_count) {
+        ++layout_version_;
+    }
+    const bool keeps_sorted = a_batch.entities.empty() || a_batch.entities.back() < entity;
+    a_batch.entities.push_back(entity);
+
+    const auto [_, is_emplaced] = key_by_entity_.try_emplace(
+        entity,
+        key{
+            .shader_id = shader_id,
+            .vertex_id = vertex_id,
+            .index = a_batch.entities.size() - 1,
+        }
+    );
+    ASSERT(is_emplaced, "entity is already batched", entity);
+
+    if (!keeps_sorted) {
+        a_batch.is_sorted = false;
+        is_dirty_ = true;
+    }
+}
+
+void draw_batch_cache::erase(entt::entity entity) {
+    const auto key_it = key_by_entity_.find(entity);
+    if (key_it == key_by_entity_.end()) {
+        return;
+    }
+    const key a_key = key_it->second;
+    key_by_entity_.erase(key_it);
+
+    batch& a_batch = sv_map_.find(a_key.shader_id).value().find(a_key.vertex_id).value();
+    ASSERT(a_key.index < a_batch.entities.size() && a_batch.entities[a_key.index] == entity);
+
+    // swap-and-pop, order gets restored in prepare
+    const entt::entity last_entity = a_batch.entities.back();
+    a_batch.entities[a_key.index] = last_entity;
+    a_batch.entities.pop_back();
+    if (last_entity != entity) {
+        key_by_entity_.find(last_entity).value().index = a_key.index;
+        a_batch.is_sorted = false;
+    }
+
+    if (a_batch.entities.empty() || !a_batch.is_sorted) {
+        is_dirty_ = true;
+    }
+}
+
+void batch_handles::prepare(std::size_t batch_count, std::size_t layout_version) {
+    if (layout_version_.has_value() && layout_version_.value() == layout_version) {
+        DEBUG_ASSERT(entries.size() == batch_count);
+        return;
+    }
+    layout_version_.emplace(layout_version);
+    entries.assign(batch_count, entry{});
+}
+
+} // namespace sl::game
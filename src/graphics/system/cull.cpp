@@ -0,0 +1,143 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/cull.hpp"
+
+#include <sl/meta/assert.hpp>
+
+#include <limits>
+#include <utility>
+
+namespace sl::game {
+namespace {
+
+// below that culling is done on the calling thread only
+constexpr std::size_t cull_min_grain = 1024;
+
+} // namespace
+
+frustum frustum::from(const camera_frame& camera_frame) {
+    // Gribb-Hartmann, clip space is -w <= x, y, z <= w
+    const glm::mat4 m = camera_frame.projection * camera_frame.view;
+    const glm::vec4 row0{ m[0][0], m[1][0], m[2][0], m[3][0] };
+    const glm::vec4 row1{ m[0][1], m[1][1], m[2][1], m[3][1] };
+    const glm::vec4 row2{ m[0][2], m[1][2], m[2][2], m[3][2] };
+    const glm::vec4 row3{ m[0][3], m[1][3], m[2][3], m[3][3] };
+
+    frustum result{ .planes{
+        row3 + row0, // left
+        row3 - row0, // right
+        row3 + row1, // bottom
+        row3 - row1, // top
+        row3 + row2, // near
+        row3 - row2, // far
+    } };
+    for (glm::vec4& plane : result.planes) {
+        plane /= glm::length(glm::vec3{ plane });
+    }
+    return result;
+}
+
+void frustum_culling::prepare(
+    ecs::layer& layer,
+    ecs::resource<vertex>& vertex_resource,
+    const draw_batch_cache::shader_to_vertex_to_batch& sv_map,
+    std::span<batch_handles::entry> handles,
+    worker_pool* workers
+) {
+    batches_.clear();
+    entities_.clear();
+    local_spheres_.clear();
+    tested_count_ = 0;
+    culled_count_ = 0;
+
+    auto handle_it = handles.begin();
+    for (const auto& [shader_id, v_map] : sv_map) {
+        for (const auto& [vertex_id, a_batch] : v_map) {
+            const std::span<const entt::entity> entities{ a_batch.entities };
+
+            ASSERT(handle_it != handles.end());
+            auto maybe_vertex_component = vertex_resource.lookup_unsafe(vertex_id, (handle_it++)->vertex);
+            if (!maybe_vertex_component.has_value()) {
+                batches_.push_back(batch_spheres{ .entities = entities, .offset = npos });
+                continue;
+            }
+            const meta::persistent<vertex> vertex_component = std::move(maybe_vertex_component).value();
+            if (!vertex_component->bounds.has_value() || vertex_component->bounds.value().is_empty()) {
+                batches_.push_back(batch_spheres{ .entities = entities, .offset = npos });
+                continue;
+            }
+
+            batches_.push_back(batch_spheres{ .entities = entities, .offset = entities_.size() });
+            entities_.insert(entities_.end(), entities.begin(), entities.end());
+            local_spheres_.insert(
+                local_spheres_.end(), entities.size(), bounding_sphere::from(vertex_component->bounds.value())
+            );
+        }
+    }
+
+    const std::size_t size = entities_.size();
+    center_x_.resize(size);
+    center_y_.resize(size);
+    center_z_.resize(size);
+    radius_.resize(size);
+
+    // storage is created lazily by registry, which is not thread-safe, so get it upfront
+    const auto& tf_storage = layer.registry.template storage<transform>();
+    parallel_for(workers, size, cull_min_grain, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const entt::entity entity = entities_[i];
+            if (!tf_storage.contains(entity)) { // can not be placed, so never culled
+                center_x_[i] = center_y_[i] = center_z_[i] = 0.0f;
+                radius_[i] = std::numeric_limits<float>::infinity();
+                continue;
+            }
+            const bounding_sphere sphere = local_spheres_[i].transformed(tf_storage.get(entity));
+            center_x_[i] = sphere.center.x;
+            center_y_[i] = sphere.center.y;
+            center_z_[i] = sphere.center.z;
+            radius_[i] = sphere.radius;
+        }
+    });
+}
+
+void frustum_culling::execute(const frustum& a_frustum, camera_visibility& visibility, worker_pool* workers) {
+    const std::size_t size = entities_.size();
+
+    is_visible_.assign(size, std::uint8_t{ 1 });
+    parallel_for(workers, size, cull_min_grain, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (const glm::vec4& plane : a_frustum.planes) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const float distance =
+                    plane.x * center_x_[i] + plane.y * center_y_[i] + plane.z * center_z_[i] + plane.w;
+                const auto is_inside = static_cast<std::uint8_t>(distance >= -radius_[i]);
+                is_visible_[i] = static_cast<std::uint8_t>(is_visible_[i] & is_inside);
+            }
+        }
+    });
+
+    // reserved upfront, so that spans into it stay valid
+    visibility.entities.clear();
+    visibility.entities.reserve(size);
+    visibility.batches.clear();
+
+    for (const batch_spheres& a_batch : batches_) {
+        if (a_batch.offset == npos) {
+            visibility.batches.push_back(a_batch.entities);
+            continue;
+        }
+        const std::size_t begin = visibility.entities.size();
+        for (std::size_t i = a_batch.offset; i < a_batch.offset + a_batch.entities.size(); ++i) {
+            if (is_visible_[i] != 0) {
+                visibility.entities.push_back(entities_[i]);
+            }
+        }
+        visibility.batches.push_back(std::span<const entt::entity>{ visibility.entities }.subspan(begin));
+    }
+
+    tested_count_ += size;
+    culled_count_ += size - visibility.entities.size();
+}
+
+} // namespace sl::game
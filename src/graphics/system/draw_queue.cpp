@@ -0,0 +1,216 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/draw_queue.hpp"
+#include "sl/game/graphics/component/vertex.hpp"
+
+#include <sl/meta/assert.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <string_view>
+#include <utility>
+
+namespace sl::game {
+namespace {
+
+constexpr std::uint32_t radix_bits = 8;
+constexpr std::uint32_t radix_size = 1u << radix_bits;
+constexpr std::uint32_t radix_pass_count = 64 / radix_bits;
+
+constexpr std::uint64_t mask(std::uint32_t bits) { return (std::uint64_t{ 1 } << bits) - 1; }
+
+// ranks of ids ordered by their strings
+tsl::robin_map<meta::unique_string, std::uint32_t> rank_by_string(std::vector<meta::unique_string> sorted) {
+    std::ranges::sort(sorted, {}, [](const meta::unique_string& id) { return id.string_view(); });
+    const auto [unique_end, _] = std::ranges::unique(sorted);
+    sorted.erase(unique_end, sorted.end());
+
+    tsl::robin_map<meta::unique_string, std::uint32_t> ranks;
+    for (std::uint32_t rank = 0; rank < sorted.size(); ++rank) {
+        ranks.emplace(sorted[rank], rank);
+    }
+    return ranks;
+}
+
+} // namespace
+
+std::uint64_t
+    draw_key::make(std::uint32_t shader_rank, std::uint32_t vertex_rank, std::uint32_t material_rank, float depth) {
+    DEBUG_ASSERT(shader_rank <= mask(shader_bits) && vertex_rank <= mask(vertex_bits));
+    std::uint64_t key = shader_rank & mask(shader_bits);
+    key = (key << vertex_bits) | (vertex_rank & mask(vertex_bits));
+    key = (key << material_bits) | std::min<std::uint64_t>(material_rank, mask(material_bits));
+    key = (key << depth_bits) | depth_key(depth);
+    return key;
+}
+
+std::uint32_t draw_key::depth_key(float depth) {
+    // sign bit is always zero, take the next depth_bits bits of exponent and mantissa
+    const auto bits = std::bit_cast<std::uint32_t>(std::max(depth, 0.0f));
+    return static_cast<std::uint32_t>((bits >> (31 - depth_bits)) & mask(depth_bits));
+}
+
+void draw_queue::prepare(
+    const draw_batch_cache::shader_to_vertex_to_batch& sv_map,
+    std::size_t layout_version,
+    std::size_t material_layout_version
+) {
+    // ranks past material_bits saturate anyway, so without material_table the map is trimmed once they do
+    if (!material_layout_version_.has_value() || material_layout_version_.value() != material_layout_version
+        || material_ranks_.size() > mask(draw_key::material_bits)) {
+        material_layout_version_.emplace(material_layout_version);
+        material_ranks_.clear();
+    }
+
+    if (layout_version_.has_value() && layout_version_.value() == layout_version) {
+        return;
+    }
+    layout_version_.emplace(layout_version);
+
+    std::vector<meta::unique_string> shader_ids;
+    std::vector<meta::unique_string> vertex_ids;
+    for (const auto& [shader_id, v_map] : sv_map) {
+        shader_ids.push_back(shader_id);
+        for (const auto& [vertex_id, a_batch] : v_map) {
+            vertex_ids.push_back(vertex_id);
+        }
+    }
+    const auto shader_ranks = rank_by_string(std::move(shader_ids));
+    const auto vertex_ranks = rank_by_string(std::move(vertex_ids));
+    ASSERT(shader_ranks.size() <= mask(draw_key::shader_bits) + 1, "too many shaders", shader_ranks.size());
+    ASSERT(vertex_ranks.size() <= mask(draw_key::vertex_bits) + 1, "too many vertices", vertex_ranks.size());
+
+    batch_ranks_.clear();
+    for (const auto& [shader_id, v_map] : sv_map) {
+        for (const auto& [vertex_id, a_batch] : v_map) {
+            batch_ranks_.push_back(batch_rank{
+                .shader_id = shader_id,
+                .vertex_id = vertex_id,
+                .shader_rank = shader_ranks.at(shader_id),
+                .vertex_rank = vertex_ranks.at(vertex_id),
+            });
+        }
+    }
+}
+
+void draw_queue::build(
+    const ecs::layer& layer,
+    const camera_visibility& visibility,
+    const std::vector<bool>& is_batch_instanced
+) {
+    DEBUG_ASSERT(visibility.batches.size() == batch_ranks_.size() && is_batch_instanced.size() == batch_ranks_.size());
+    entries_.clear();
+    items_.clear();
+
+    // const registry yields nullptr if the storage was never created
+    const auto* maybe_tf_storage = layer.registry.template storage<transform>();
+    const auto* maybe_mat_storage = layer.registry.template storage<material::id>();
+    // view space depth is the dot product with the third row of view matrix
+    const glm::mat4& view = visibility.frame.view;
+    const glm::vec4 depth_row{ -view[0][2], -view[1][2], -view[2][2], -view[3][2] };
+
+    for (std::uint32_t batch_index = 0; batch_index < batch_ranks_.size(); ++batch_index) {
+        const std::span<const entt::entity> entities = visibility.batches[batch_index];
+        if (entities.empty()) {
+            continue;
+        }
+        const batch_rank& rank = batch_ranks_[batch_index];
+        if (is_batch_instanced[batch_index]) {
+            entries_.push_back(entry{
+                .key = draw_key::make(rank.shader_rank, rank.vertex_rank, 0, 0.0f),
+                .item = static_cast<std::uint32_t>(items_.size()),
+            });
+            items_.push_back(item{ .entity = entt::null, .batch_index = batch_index });
+            continue;
+        }
+        for (const entt::entity entity : entities) {
+            std::uint32_t a_material_rank = 0;
+            if (maybe_mat_storage != nullptr && maybe_mat_storage->contains(entity)) {
+                a_material_rank = material_rank(maybe_mat_storage->get(entity).id);
+            }
+            float depth = 0.0f;
+            if (maybe_tf_storage != nullptr && maybe_tf_storage->contains(entity)) {
+                depth = glm::dot(depth_row, glm::vec4{ maybe_tf_storage->get(entity).tr, 1.0f });
+            }
+            entries_.push_back(entry{
+                .key = draw_key::make(rank.shader_rank, rank.vertex_rank, a_material_rank, depth),
+                .item = static_cast<std::uint32_t>(items_.size()),
+            });
+            items_.push_back(item{ .entity = entity, .batch_index = batch_index });
+        }
+    }
+
+    sort();
+
+    entities_.clear();
+    entities_.reserve(entries_.size()); // runs keep spans into it
+    runs_.clear();
+    material_change_count_ = 0;
+    constexpr std::uint32_t run_shift = draw_key::material_bits + draw_key::depth_bits;
+    constexpr std::uint32_t material_shift = draw_key::depth_bits;
+    // material prefix includes shader and vertex, so that switching batches counts as a change too
+    std::uint64_t previous_material = ~std::uint64_t{ 0 };
+    for (std::size_t i = 0; i < entries_.size();) {
+        const std::uint64_t run_prefix = entries_[i].key >> run_shift;
+        const item& first_item = items_[entries_[i].item];
+        const batch_rank& rank = batch_ranks_[first_item.batch_index];
+        const std::size_t entities_begin = entities_.size();
+        for (; i < entries_.size() && entries_[i].key >> run_shift == run_prefix; ++i) {
+            const item& an_item = items_[entries_[i].item];
+            if (an_item.entity == entt::null) {
+                continue;
+            }
+            entities_.push_back(an_item.entity);
+            const std::uint64_t material = entries_[i].key >> material_shift;
+            material_change_count_ += material != std::exchange(previous_material, material);
+        }
+        runs_.push_back(run{
+            .shader_id = rank.shader_id,
+            .vertex_id = rank.vertex_id,
+            .batch_index = first_item.batch_index,
+            .entities{ entities_.data() + entities_begin, entities_.size() - entities_begin },
+        });
+    }
+}
+
+std::uint32_t draw_queue::material_rank(meta::unique_string material_id) {
+    const auto [it, _] = material_ranks_.try_emplace(material_id, static_cast<std::uint32_t>(material_ranks_.size()));
+    return it->second;
+}
+
+void draw_queue::sort() {
+    // bytes which are equal for every key are skipped, which are usually the top ones
+    std::uint64_t differing_bits = 0;
+    if (!entries_.empty()) {
+        for (const entry& an_entry : entries_) {
+            differing_bits |= an_entry.key ^ entries_.front().key;
+        }
+    }
+
+    scratch_.resize(entries_.size());
+    std::array<std::uint32_t, radix_size> offsets{};
+    for (std::uint32_t pass = 0; pass < radix_pass_count; ++pass) {
+        const std::uint32_t shift = pass * radix_bits;
+        if (((differing_bits >> shift) & mask(radix_bits)) == 0) {
+            continue;
+        }
+
+        offsets.fill(0);
+        for (const entry& an_entry : entries_) {
+            ++offsets[(an_entry.key >> shift) & mask(radix_bits)];
+        }
+        std::uint32_t sum = 0;
+        for (std::uint32_t& offset : offsets) {
+            sum += std::exchange(offset, sum);
+        }
+        for (const entry& an_entry : entries_) {
+            scratch_[offsets[(an_entry.key >> shift) & mask(radix_bits)]++] = an_entry;
+        }
+        std::swap(entries_, scratch_);
+    }
+}
+
+} // namespace sl::game
@@ -0,0 +1,177 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/material.hpp"
+#include "sl/game/detail/log.hpp"
+
+#include <sl/ecs/resource.hpp>
+
+#include <utility>
+#include <variant>
+
+namespace sl::game {
+
+material_binder& material_binder::of(ecs::layer& layer) {
+    if (auto* maybe_binder = layer.registry.try_get<ptr_type>(layer.root); maybe_binder != nullptr) {
+        return **maybe_binder;
+    }
+    return *layer.registry.emplace<ptr_type>(layer.root, make());
+}
+
+material_binder::handle material_binder::handle_of(meta::unique_string material_id) {
+    const auto [it, _] =
+        handles_.try_emplace(material_id, handle{ .index = static_cast<std::uint32_t>(handles_.size()) });
+    return it->second;
+}
+
+meta::maybe<material_binder::handle> material_binder::find(meta::unique_string material_id) const {
+    if (const auto it = handles_.find(material_id); it != handles_.end()) {
+        return it->second;
+    }
+    return meta::null;
+}
+
+bool material_binder::apply(handle a_handle) {
+    if (applied_.has_value() && applied_.value() == a_handle) {
+        ++stats_.redundant_material_apply_count;
+        return false;
+    }
+    applied_.emplace(a_handle);
+    ++stats_.material_apply_count;
+    return true;
+}
+
+void material_binder::bind_texture(std::uint32_t unit, const meta::persistent<texture>& tex) {
+    if (texture_units_.size() <= unit) {
+        texture_units_.resize(unit + 1);
+    }
+    texture_unit& a_unit = texture_units_[unit];
+    if (a_unit.texture == &tex->tex) {
+        ++stats_.redundant_texture_bind_count;
+        return;
+    }
+    // released before activating the new one, so that it does not unbind the unit after
+    a_unit.bound.reset();
+    a_unit.bound.emplace(tex->tex.activate(unit));
+    a_unit.texture = &tex->tex;
+    ++stats_.texture_bind_count;
+}
+
+void material_binder::begin_frame() {
+    stats_ = material_bind_stats{};
+    applied_ = meta::null;
+    texture_units_.clear();
+}
+
+void material_binder::end_frame() {
+    applied_ = meta::null;
+    texture_units_.clear();
+}
+
+meta::maybe<material_element> material_element::from(const material& a_material) {
+    material_element element{ .shininess = a_material.shininess, .mode = 0 };
+
+    // false if the texture is not packed into texture_arrays
+    const auto pack = [&element](const texture_or_color& tex_or_clr, std::uint32_t texture_bit, glm::vec4& color) {
+        if (const auto* maybe_color = std::get_if<glm::vec4>(&tex_or_clr); maybe_color != nullptr) {
+            color = *maybe_color;
+            return true;
+        }
+        const auto& maybe_layer = std::get<ecs::resource_reference<texture>>(tex_or_clr)->layer;
+        if (!maybe_layer.has_value()) {
+            return false;
+        }
+        element.mode |= texture_bit;
+        const texture_layer& layer = maybe_layer.value().location();
+        if (texture_bit == diffuse_texture_bit) {
+            element.diffuse_array = layer.array;
+            element.diffuse_layer = layer.layer;
+        } else {
+            element.specular_array = layer.array;
+            element.specular_layer = layer.layer;
+        }
+        return true;
+    };
+    if (!pack(a_material.diffuse, diffuse_texture_bit, element.diffuse_color)
+        || !pack(a_material.specular, specular_texture_bit, element.specular_color)) {
+        return meta::null;
+    }
+    return element;
+}
+
+material_table& material_table::of(ecs::layer& layer) {
+    if (auto* maybe_table = layer.registry.try_get<ptr_type>(layer.root); maybe_table != nullptr) {
+        return **maybe_table;
+    }
+    return *layer.registry.emplace<ptr_type>(layer.root, make(layer));
+}
+
+material_table::material_table(ecs::layer& layer) : layer_{ layer }, binder_{ material_binder::of(layer) } {
+    auto& registry = layer_.registry;
+    registry.on_construct<material::id>().connect<&material_table::on_change>(*this);
+    registry.on_update<material::id>().connect<&material_table::on_change>(*this);
+    for (const auto& [entity, mat_id] : registry.view<material::id>().each()) {
+        marked_.push_back(mat_id.id);
+    }
+}
+
+material_table::~material_table() {
+    auto& registry = layer_.registry;
+    registry.on_construct<material::id>().disconnect(*this);
+    registry.on_update<material::id>().disconnect(*this);
+}
+
+void material_table::update() {
+    if (!marked_.empty()) {
+        auto* const maybe_mat_resource = layer_.registry.try_get<ecs::resource<material>::ptr_type>(layer_.root);
+        // materials which are not loaded yet stay marked
+        std::erase_if(marked_, [&](meta::unique_string material_id) {
+            if (index_by_id_.contains(material_id) || unpackable_.contains(material_id)) {
+                return true;
+            }
+            if (maybe_mat_resource == nullptr) {
+                return false;
+            }
+            const auto maybe_mat = (*maybe_mat_resource)->lookup_unsafe(material_id);
+            if (!maybe_mat.has_value()) {
+                return false;
+            }
+            const auto& a_material = maybe_mat.value();
+            auto maybe_element = material_element::from(*a_material);
+            if (!maybe_element.has_value()) {
+                log::warn(
+                    "[material_table] material.id={} has textures out of texture_arrays", material_id.string_view()
+                );
+                unpackable_.insert(material_id);
+                return true;
+            }
+
+            const std::uint32_t index = binder_.handle_of(material_id).index;
+            if (elements_.size() <= index) {
+                elements_.resize(index + 1, material_element{});
+            }
+            elements_[index] = std::move(maybe_element).value();
+            index_by_id_.emplace(material_id, index);
+            is_dirty_ = true;
+            ++layout_version_;
+            return true;
+        });
+    }
+
+    if (std::exchange(is_dirty_, false)) {
+        log::trace("[material_table] size={}", elements_.size());
+        ssbo_.upload(elements_);
+    }
+}
+
+std::uint32_t material_table::index_of(meta::unique_string material_id) const {
+    const auto it = index_by_id_.find(material_id);
+    return it != index_by_id_.end() ? it->second : no_index;
+}
+
+void material_table::on_change(entt::registry& registry, entt::entity entity) {
+    marked_.push_back(registry.get<material::id>(entity).id);
+}
+
+} // namespace sl::game
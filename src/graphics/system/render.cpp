@@ -4,18 +4,230 @@
 
 #include "sl/game/graphics/system/render.hpp"
 #include "sl/game/detail/log.hpp"
+#include "sl/game/graphics/buffer.hpp"
 #include "sl/game/graphics/component/vertex.hpp"
 
 #include <sl/ecs/resource.hpp>
 
 #include <sl/meta/assert.hpp>
-#include <tsl/robin_map.h>
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <variant>
 
 namespace sl::game {
+namespace {
+
+// packs instance_element of every visible entity of instanced batches into one ssbo,
+// all batches of all cameras share a single map
+void upload_instances(
+    const ecs::layer& layer,
+    const basis& world,
+    ecs::resource<shader>& shader_resource,
+    ecs::resource<vertex>& vertex_resource,
+    const draw_batch_cache::shader_to_vertex_to_batch& sv_map,
+    std::span<batch_handles::entry> handles,
+    std::span<const camera_visibility> visibilities,
+    worker_pool* workers,
+    instance_buffer& instances
+) {
+    instances.is_batch_instanced.clear();
+    instances.batches.clear();
+    instances.ranges.clear();
+
+    auto handle_it = handles.begin();
+    for (const auto& [shader_id, v_map] : sv_map) {
+        ASSERT(handle_it != handles.end());
+        bool is_shader_instanced = false;
+        if (auto maybe_shader_component = shader_resource.lookup_unsafe(shader_id, handle_it->shader);
+            maybe_shader_component.has_value()) {
+            const meta::persistent<shader> shader_component = std::move(maybe_shader_component).value();
+            is_shader_instanced = static_cast<bool>(shader_component->setup_instanced);
+        }
+
+        for (const auto& [vertex_id, a_batch] : v_map) {
+            ASSERT(handle_it != handles.end());
+            batch_handles::entry& batch_handle = *handle_it++;
+            bool is_instanced = false;
+            if (auto maybe_vertex_component = vertex_resource.lookup_unsafe(vertex_id, batch_handle.vertex);
+                is_shader_instanced && maybe_vertex_component.has_value()) {
+                const meta::persistent<vertex> vertex_component = std::move(maybe_vertex_component).value();
+                is_instanced = static_cast<bool>(vertex_component->draw_instanced);
+            }
+            instances.is_batch_instanced.push_back(is_instanced);
+        }
+    }
+
+    std::size_t instance_count = 0;
+    for (const camera_visibility& visibility : visibilities) {
+        DEBUG_ASSERT(visibility.batches.size() == instances.is_batch_instanced.size());
+        for (std::size_t batch_index = 0; batch_index < visibility.batches.size(); ++batch_index) {
+            if (!instances.is_batch_instanced[batch_index]) {
+                continue;
+            }
+            const std::span<const entt::entity> entities = visibility.batches[batch_index];
+            instances.batches.push_back(entities);
+            instance_count += entities.size();
+        }
+    }
+
+    if (instances.batches.empty()) {
+        return;
+    }
+
+    if (instances.capacity.fit(instance_count) || instances.ring == nullptr) {
+        log::debug("[graphics_system] instance capacity={}", instances.capacity.capacity);
+        instances.ring = std::make_unique<instance_buffer::ring_type>(instances.capacity.capacity);
+    }
+
+    // region of the current frame, gpu may still read regions of previous ones
+    const std::span<instance_element> mapped_ssbo_data = instances.ring->begin_frame();
+
+    std::uint32_t base = 0;
+    for (const std::span<const entt::entity> entities : instances.batches) {
+        const std::span<instance_element> batch_ssbo_data = mapped_ssbo_data.subspan(base);
+        const std::uint32_t count =
+            workers == nullptr
+                ? fill_ssbo(layer, world, batch_ssbo_data, entities)
+                : fill_ssbo(layer, world, batch_ssbo_data, entities, *workers, instances.fill_chunks);
+        instances.ranges.push_back(instance_range{ .base = base, .count = count });
+        base += count;
+    }
+}
+
+gfx::vertex_array& vertex_array_of(std::variant<gfx::vertex_array, pooled_geometry>& va) {
+    if (auto* const maybe_pooled = std::get_if<pooled_geometry>(&va); maybe_pooled != nullptr) {
+        return maybe_pooled->pool().va();
+    }
+    return std::get<gfx::vertex_array>(va);
+}
+
+// batches of one pool share the vertex array, so each pool is bound once and drawn by a single multi draw
+void submit_multi_draws(
+    shader::draw_instanced_type& draw_instanced,
+    multi_draw_buffer& multi_draws,
+    draw_stats& stats
+) {
+    using pooled_batch = multi_draw_buffer::pooled_batch;
+    std::ranges::stable_sort(multi_draws.batches, std::less{}, &pooled_batch::pool);
+
+    for (auto batch_it = multi_draws.batches.begin(); batch_it != multi_draws.batches.end();) {
+        geometry_pool_base* const pool = batch_it->pool;
+        // commands carry their own base instances, so the range only reports the first one and the total count
+        const std::uint32_t first_instance = batch_it->command.base_instance;
+        std::uint32_t instance_count = 0;
+        multi_draws.commands.clear();
+        for (; batch_it != multi_draws.batches.end() && batch_it->pool == pool; ++batch_it) {
+            multi_draws.commands.push_back(batch_it->command);
+            instance_count += batch_it->command.instance_count;
+        }
+
+        const auto bound_va = pool->va().bind();
+        ++stats.vertex_array_bind_count;
+        vertex::draw_instanced_type multi_draw{ [&multi_draws](gfx::draw&, std::uint32_t, std::uint32_t) {
+            multi_draws.indirect.multi_draw(multi_draws.commands);
+        } };
+        draw_instanced(bound_va, multi_draw, instance_range{ .base = first_instance, .count = instance_count });
+        ++stats.draw_count;
+        stats.multi_draw_command_count += multi_draws.commands.size();
+    }
+    multi_draws.batches.clear();
+}
+
+// binds the program of runs once and draws every run, all runs have to share the shader
+void submit_shader_runs(
+    ecs::layer& layer,
+    ecs::resource<shader>& shader_resource,
+    ecs::resource<vertex>& vertex_resource,
+    const camera_frame& camera_frame,
+    std::span<const draw_queue::run> runs,
+    std::span<batch_handles::entry> handles,
+    const instance_buffer& instances,
+    material_binder& materials,
+    multi_draw_buffer& multi_draws,
+    draw_stats& stats
+) {
+    const meta::unique_string shader_id = runs.front().shader_id;
+    auto maybe_shader_component = shader_resource.lookup_unsafe(shader_id, handles[runs.front().batch_index].shader);
+    if (!maybe_shader_component.has_value()) {
+        log::trace("shader.id={} not found", shader_id.string_view());
+        return;
+    }
+    meta::persistent<shader> shader_component = std::move(maybe_shader_component).value();
+    ASSERT(shader_component->setup || shader_component->setup_instanced);
+
+    const auto bound_sp = shader_component->sp.bind();
+    ++stats.program_bind_count;
+    materials.invalidate();
+    shader::draw_instanced_type draw_instanced{};
+    if (shader_component->setup_instanced) {
+        draw_instanced = shader_component->setup_instanced(layer, camera_frame, bound_sp);
+        ASSERT(draw_instanced);
+    }
+    shader::draw_type draw{}; // only set up if some vertex can not be drawn instanced
+
+    for (const draw_queue::run& run : runs) {
+        auto maybe_vertex_component = vertex_resource.lookup_unsafe(run.vertex_id, handles[run.batch_index].vertex);
+        if (!maybe_vertex_component.has_value()) {
+            log::trace("vertex.id={} not found", run.vertex_id.string_view());
+            continue;
+        }
+        meta::persistent<vertex> vertex_component = std::move(maybe_vertex_component).value();
+        const bool is_instanced = instances.is_batch_instanced[run.batch_index];
+        if (const auto* const maybe_pooled = std::get_if<pooled_geometry>(&vertex_component->va);
+            is_instanced && maybe_pooled != nullptr) {
+            geometry_pool_base& pool = maybe_pooled->pool();
+            // rebuilds the pool before its range is read, since compaction may move it
+            std::ignore = pool.va();
+            const geometry_range geometry = maybe_pooled->range();
+            const instance_range range = instances.ranges_by_batch[run.batch_index];
+            multi_draws.batches.push_back(multi_draw_buffer::pooled_batch{
+                .pool = &pool,
+                .command{
+                    .count = geometry.index_count,
+                    .instance_count = range.count,
+                    .first_index = geometry.first_index,
+                    .base_vertex = geometry.base_vertex,
+                    .base_instance = range.base,
+                },
+            });
+            continue;
+        }
+
+        const auto bound_va = vertex_array_of(vertex_component->va).bind();
+        ++stats.vertex_array_bind_count;
+
+        if (is_instanced) {
+            draw_instanced(bound_va, vertex_component->draw_instanced, instances.ranges_by_batch[run.batch_index]);
+            ++stats.draw_count;
+            continue;
+        }
+
+        if (!shader_component->setup) {
+            log::trace("shader.id={} can only draw instanced vertices", shader_id.string_view());
+            continue;
+        }
+        if (!draw) {
+            draw = shader_component->setup(layer, camera_frame, bound_sp);
+            ASSERT(draw);
+        }
+        ASSERT(vertex_component->draw);
+        draw(bound_va, vertex_component->draw, run.entities);
+        stats.draw_count += run.entities.size();
+    }
+
+    if (!multi_draws.batches.empty()) {
+        submit_multi_draws(draw_instanced, multi_draws, stats);
+    }
+}
+
+} // namespace
 
 meta::result<meta::unit, graphics_system::error_type> graphics_system::execute(const window_frame& a_window_frame) & {
-    using vertex_to_entities = tsl::robin_map</* vertex */ meta::unique_string, std::vector<entt::entity>>;
-    using shader_to_vertices_to_entities = tsl::robin_map</* shader */ meta::unique_string, vertex_to_entities>;
+    stats.reset();
+    materials.begin_frame();
 
     auto* const maybe_shader_resource = layer.registry.try_get<ecs::resource<shader>::ptr_type>(layer.root);
     if (maybe_shader_resource == nullptr) {
@@ -31,57 +243,111 @@ meta::result<meta::unit, graphics_system::error_type> graphics_system::execute(c
     }
     auto& vertex_resource = **maybe_vertex_resource;
 
-    // Im thinking that recalculating these is much better then .
-    // Having to keep track of appearing entities/components (essentially caching) might come with other more subtle
-    // performance costs.
-    const shader_to_vertices_to_entities sve_map = std::invoke([this] {
-        shader_to_vertices_to_entities sve_map;
-        const auto entities = layer.registry.template view<typename shader::id, vertex::id>();
-        for (const auto& [entity, shader, vertex] : entities.each()) {
-            sve_map[shader.id][vertex.id].push_back(entity);
-        }
-        return sve_map;
-    });
-    if (sve_map.empty()) {
+    const draw_batch_cache::shader_to_vertex_to_batch& sv_map = batches->prepare();
+    if (sv_map.empty()) {
         log::trace("no entities with shader::id and vertex::id found");
     }
 
     const auto camera_entities = layer.registry.template view<camera, transform>();
     if (camera_entities.size_hint() == 0) {
         log::trace("no camera entities found");
+        return meta::unit{};
+    }
+
+    std::size_t batch_count = 0;
+    for (const auto& [shader_id, v_map] : sv_map) {
+        batch_count += v_map.size();
     }
+    handles.prepare(batch_count, batches->layout_version());
 
+    // world space bounds do not depend on camera
+    culling.prepare(layer, vertex_resource, sv_map, handles.entries, workers);
+    std::size_t camera_count = 0;
     for (const auto& [camera_entity, camera_component, camera_tf] : camera_entities.each()) {
-        const auto camera_frame = a_window_frame.for_camera(world, camera_component, camera_tf);
+        if (visibilities.size() == camera_count) {
+            visibilities.emplace_back();
+        }
+        camera_visibility& visibility = visibilities[camera_count++];
+        visibility.frame = a_window_frame.for_camera(world, camera_component, camera_tf);
+        culling.execute(frustum::from(visibility.frame), visibility, workers);
+    }
+    const std::span<const camera_visibility> frame_visibilities = std::span{ visibilities }.first(camera_count);
+    log::trace("[graphics_system] culled={} of tested={}", culling.culled_count(), culling.tested_count());
 
-        for (const auto& [shader_id, ve_map] : sve_map) {
-            auto maybe_shader_component = shader_resource.lookup_unsafe(shader_id);
-            if (!maybe_shader_component.has_value()) {
-                log::trace("shader.id={} not found", shader_id.string_view());
-                continue;
+    // instance_element reads material indices, so new materials are packed before
+    auto* const maybe_material_table = layer.registry.try_get<material_table::ptr_type>(layer.root);
+    if (maybe_material_table != nullptr) {
+        (*maybe_material_table)->update();
+    }
+    // instance data of all cameras is uploaded at once
+    upload_instances(
+        layer, world, shader_resource, vertex_resource, sv_map, handles.entries, frame_visibilities, workers, instances
+    );
+    if (!instances.ranges.empty()) {
+        const instance_range& last_range = instances.ranges.back();
+        instances.ring->bind_range(instance_element::binding, last_range.base + last_range.count);
+    }
+    // ranges are per camera, then per instanced batch in sv_map order
+    auto instance_range_it = instances.ranges.begin();
+    queue.prepare(
+        sv_map,
+        batches->layout_version(),
+        maybe_material_table != nullptr ? (*maybe_material_table)->layout_version() : 0
+    );
+
+    for (const camera_visibility& visibility : frame_visibilities) {
+        instances.ranges_by_batch.assign(instances.is_batch_instanced.size(), instance_range{});
+        for (std::size_t batch_index = 0; batch_index < instances.is_batch_instanced.size(); ++batch_index) {
+            if (instances.is_batch_instanced[batch_index]) {
+                ASSERT(instance_range_it != instances.ranges.end());
+                instances.ranges_by_batch[batch_index] = *instance_range_it++;
             }
-            meta::persistent<shader> shader_component = std::move(maybe_shader_component).value();
-            ASSERT(shader_component->setup);
+        }
 
-            const auto bound_sp = shader_component->sp.bind();
-            auto draw = shader_component->setup(layer, camera_frame, bound_sp);
-            ASSERT(draw);
+        queue.build(layer, visibility, instances.is_batch_instanced);
+        stats.material_change_count += queue.material_change_count();
 
-            for (const auto& [vertex_id, entities] : ve_map) {
-                auto maybe_vertex_component = vertex_resource.lookup_unsafe(vertex_id);
-                if (!maybe_vertex_component.has_value()) {
-                    log::trace("vertex.id={} not found", vertex_id.string_view());
-                    continue;
-                }
-                meta::persistent<vertex> vertex_component = std::move(maybe_vertex_component).value();
-                ASSERT(vertex_component->draw);
-
-                const auto bound_va = vertex_component->va.bind();
-                draw(bound_va, vertex_component->draw, std::span{ entities });
+        // runs of one shader are adjacent, so every program is bound once per camera
+        const std::span<const draw_queue::run> runs = queue.runs();
+        for (std::size_t shader_begin = 0; shader_begin < runs.size();) {
+            std::size_t shader_end = shader_begin + 1;
+            while (shader_end < runs.size() && runs[shader_end].shader_id == runs[shader_begin].shader_id) {
+                ++shader_end;
             }
+            submit_shader_runs(
+                layer,
+                shader_resource,
+                vertex_resource,
+                visibility.frame,
+                runs.subspan(shader_begin, shader_end - shader_begin),
+                handles.entries,
+                instances,
+                materials,
+                multi_draws,
+                stats
+            );
+            shader_begin = shader_end;
         }
     }
 
+    stats.texture_bind_count = materials.stats().texture_bind_count;
+    stats.redundant_bind_count = materials.stats().redundant_bind_count();
+    materials.end_frame();
+    log::trace(
+        "[graphics_system] program_binds={} vertex_array_binds={} material_changes={} draws={} multi_draw_commands={} "
+        "texture_binds={} redundant_binds={}",
+        stats.program_bind_count,
+        stats.vertex_array_bind_count,
+        stats.material_change_count,
+        stats.draw_count,
+        stats.multi_draw_command_count,
+        stats.texture_bind_count,
+        stats.redundant_bind_count
+    );
+
+    if (instances.ring != nullptr && instances.ring->is_frame_begun()) {
+        instances.ring->end_frame();
+    }
     return meta::unit{};
 }
 
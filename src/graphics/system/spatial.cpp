@@ -0,0 +1,349 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/spatial.hpp"
+#include "sl/game/detail/log.hpp"
+
+#include <sl/meta/assert.hpp>
+#include <sl/meta/monad/maybe.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+
+namespace sl::game {
+namespace {
+
+// below that boxes are updated on the calling thread only
+constexpr std::size_t update_min_grain = 4096;
+
+// refitted tree is rebuilt once its nodes are that much larger in total than right after building
+constexpr float rebuild_area_ratio = 2.0f;
+
+bool overlaps(const frustum& a_frustum, const aabb& box) {
+    const glm::vec3 center = box.center();
+    const glm::vec3 extent = box.extent();
+    for (const glm::vec4& plane : a_frustum.planes) {
+        const glm::vec3 normal{ plane };
+        const float radius = glm::dot(glm::abs(normal), extent);
+        if (glm::dot(normal, center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool overlaps(const bounding_sphere& sphere, const aabb& box) {
+    const glm::vec3 closest = glm::clamp(sphere.center, box.min, box.max);
+    const glm::vec3 delta = closest - sphere.center;
+    return glm::dot(delta, delta) <= sphere.radius * sphere.radius;
+}
+
+// distance along the ray at which it enters the box
+meta::maybe<float> entry_distance(const ray& a_ray, const glm::vec3& inverse_direction, const aabb& box) {
+    float t_enter = 0.0f;
+    float t_exit = a_ray.max_distance;
+    for (glm::length_t axis = 0; axis < 3; ++axis) {
+        const float origin = a_ray.origin[axis];
+        // parallel to the slab, its inverse is infinite and gives 0 * inf = NaN for an origin on a slab plane
+        if (a_ray.direction[axis] == 0.0f) {
+            if (origin < box.min[axis] || origin > box.max[axis]) {
+                return meta::null;
+            }
+            continue;
+        }
+        const float t0 = (box.min[axis] - origin) * inverse_direction[axis];
+        const float t1 = (box.max[axis] - origin) * inverse_direction[axis];
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+    if (t_enter > t_exit) {
+        return meta::null;
+    }
+    return t_enter;
+}
+
+} // namespace
+
+spatial_index::spatial_index(entt::registry& registry) : registry_{ registry } {
+    registry_.on_construct<aabb>().connect<&spatial_index::on_structure_change>(*this);
+    registry_.on_destroy<aabb>().connect<&spatial_index::on_structure_change>(*this);
+    registry_.on_construct<transform>().connect<&spatial_index::on_structure_change>(*this);
+    registry_.on_destroy<transform>().connect<&spatial_index::on_structure_change>(*this);
+    registry_.on_update<aabb>().connect<&spatial_index::on_box_change>(*this);
+    registry_.on_update<transform>().connect<&spatial_index::on_box_change>(*this);
+}
+
+spatial_index::~spatial_index() {
+    registry_.on_construct<aabb>().disconnect(*this);
+    registry_.on_destroy<aabb>().disconnect(*this);
+    registry_.on_construct<transform>().disconnect(*this);
+    registry_.on_destroy<transform>().disconnect(*this);
+    registry_.on_update<aabb>().disconnect(*this);
+    registry_.on_update<transform>().disconnect(*this);
+}
+
+void spatial_index::update(worker_pool* workers) {
+    if (is_structure_dirty_) {
+        rebuild(workers);
+        return;
+    }
+
+    if (dirty_boxes_.empty()) {
+        return;
+    }
+    update_boxes(dirty_boxes_, workers);
+    const float area = refit();
+    ++refit_count_;
+
+    // tree of points only has no area to compare against
+    if (built_area_ > 0.0f && area > rebuild_area_ratio * built_area_) {
+        log::trace("[spatial_index] refitted area={} exceeds built area={}, rebuilding", area, built_area_);
+        rebuild(workers);
+    }
+}
+
+void spatial_index::rebuild(worker_pool* workers) {
+    is_structure_dirty_ = false;
+    ++rebuild_count_;
+
+    entities_.clear();
+    for (const entt::entity entity : registry_.view<aabb, transform>()) {
+        entities_.push_back(entity);
+    }
+    const auto size = static_cast<index_type>(entities_.size());
+    boxes_.resize(size);
+    update_boxes(workers);
+
+    nodes_.clear();
+    parent_of_.clear();
+    leaf_of_.clear();
+    index_by_entity_.clear();
+    dirty_boxes_.clear();
+    is_box_dirty_.assign(size, std::uint8_t{ 0 });
+    dirty_nodes_.clear();
+    built_area_ = 0.0f;
+    area_ = 0.0f;
+    if (size == 0) {
+        return;
+    }
+
+    std::vector<index_type> order(size);
+    std::iota(order.begin(), order.end(), index_type{ 0 });
+    std::vector<glm::vec3> centers(size);
+    std::ranges::transform(boxes_, centers.begin(), [](const aabb& box) { return box.center(); });
+
+    // top-down median split along the longest axis of centers
+    struct pending_node {
+        index_type node;
+        index_type begin;
+        index_type end;
+    };
+    std::vector<pending_node> pending{ pending_node{ .node = 0, .begin = 0, .end = size } };
+    nodes_.push_back(bvh_node{ .box{}, .first = 0, .count = size });
+
+    while (!pending.empty()) {
+        const pending_node current = pending.back();
+        pending.pop_back();
+
+        aabb box;
+        aabb center_box;
+        for (index_type i = current.begin; i < current.end; ++i) {
+            box.extend(boxes_[order[i]]);
+            center_box.extend(centers[order[i]]);
+        }
+
+        const glm::vec3 center_size = center_box.max - center_box.min;
+        const index_type count = current.end - current.begin;
+        if (count <= leaf_size || center_size == glm::vec3{ 0.0f }) {
+            nodes_[current.node] = bvh_node{ .box = box, .first = current.begin, .count = count };
+            continue;
+        }
+
+        const glm::length_t axis = center_size.x > center_size.y ? (center_size.x > center_size.z ? 0 : 2)
+                                                                 : (center_size.y > center_size.z ? 1 : 2);
+        const index_type middle = current.begin + count / 2;
+        std::nth_element(
+            order.begin() + current.begin,
+            order.begin() + middle,
+            order.begin() + current.end,
+            [&centers, axis](index_type lhs, index_type rhs) { return centers[lhs][axis] < centers[rhs][axis]; }
+        );
+
+        const auto left = static_cast<index_type>(nodes_.size());
+        nodes_.resize(nodes_.size() + 2);
+        nodes_[current.node] = bvh_node{ .box = box, .first = left, .count = 0 };
+        pending.push_back(pending_node{ .node = left, .begin = current.begin, .end = middle });
+        pending.push_back(pending_node{ .node = left + 1, .begin = middle, .end = current.end });
+    }
+
+    // leaves reference contiguous ranges, so store entities in leaf order
+    std::vector<entt::entity> ordered_entities(size);
+    std::vector<aabb> ordered_boxes(size);
+    for (index_type i = 0; i < size; ++i) {
+        ordered_entities[i] = entities_[order[i]];
+        ordered_boxes[i] = boxes_[order[i]];
+    }
+    entities_ = std::move(ordered_entities);
+    boxes_ = std::move(ordered_boxes);
+
+    index_by_entity_.reserve(size);
+    for (index_type i = 0; i < size; ++i) {
+        index_by_entity_.emplace(entities_[i], i);
+    }
+    parent_of_.assign(nodes_.size(), npos);
+    leaf_of_.resize(size);
+    is_node_dirty_.assign(nodes_.size(), std::uint8_t{ 0 });
+    for (index_type n = 0; n < nodes_.size(); ++n) {
+        const bvh_node& node = nodes_[n];
+        if (node.count == 0) {
+            parent_of_[node.first] = n;
+            parent_of_[node.first + 1] = n;
+        } else {
+            std::fill_n(leaf_of_.begin() + node.first, node.count, n);
+        }
+        built_area_ += node.box.surface_area();
+    }
+    area_ = built_area_;
+    log::trace("[spatial_index] rebuilt entities={} nodes={}", entities_.size(), nodes_.size());
+}
+
+void spatial_index::update_boxes(worker_pool* workers) {
+    // storages are created lazily by registry, which is not thread-safe, so get them upfront
+    const auto& aabb_storage = registry_.storage<aabb>();
+    const auto& tf_storage = registry_.storage<transform>();
+    parallel_for(workers, entities_.size(), update_min_grain, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const entt::entity entity = entities_[i];
+            boxes_[i] = aabb_storage.get(entity).transformed(tf_storage.get(entity));
+        }
+    });
+}
+
+void spatial_index::update_boxes(std::span<const index_type> indices, worker_pool* workers) {
+    const auto& aabb_storage = registry_.storage<aabb>();
+    const auto& tf_storage = registry_.storage<transform>();
+    parallel_for(workers, indices.size(), update_min_grain, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (const index_type i : indices.subspan(begin, end - begin)) {
+            const entt::entity entity = entities_[i];
+            boxes_[i] = aabb_storage.get(entity).transformed(tf_storage.get(entity));
+        }
+    });
+}
+
+void spatial_index::on_structure_change(entt::registry&, entt::entity entity) {
+    // on_destroy is called before removal, so entities that are indexed still have both
+    if (registry_.all_of<aabb, transform>(entity)) {
+        is_structure_dirty_ = true;
+    }
+}
+
+void spatial_index::on_box_change(entt::registry&, entt::entity entity) {
+    if (is_structure_dirty_) {
+        return;
+    }
+    const auto index_it = index_by_entity_.find(entity);
+    if (index_it == index_by_entity_.end()) { // has transform, but no aabb
+        return;
+    }
+    const index_type i = index_it->second;
+    if (is_box_dirty_[i] == 0) {
+        is_box_dirty_[i] = 1;
+        dirty_boxes_.push_back(i);
+    }
+}
+
+float spatial_index::refit() {
+    dirty_nodes_.clear();
+    for (const index_type i : dirty_boxes_) {
+        is_box_dirty_[i] = 0;
+        for (index_type n = leaf_of_[i]; n != npos && is_node_dirty_[n] == 0; n = parent_of_[n]) {
+            is_node_dirty_[n] = 1;
+            dirty_nodes_.push_back(n);
+        }
+    }
+    dirty_boxes_.clear();
+
+    // children are placed after their parent, so descending order is bottom-up
+    std::ranges::sort(dirty_nodes_, std::greater{});
+    for (const index_type n : dirty_nodes_) {
+        is_node_dirty_[n] = 0;
+        bvh_node& node = nodes_[n];
+        aabb box;
+        if (node.count > 0) {
+            for (index_type k = node.first; k < node.first + node.count; ++k) {
+                box.extend(boxes_[k]);
+            }
+        } else {
+            box.extend(nodes_[node.first].box);
+            box.extend(nodes_[node.first + 1].box);
+        }
+        area_ += box.surface_area() - node.box.surface_area();
+        node.box = box;
+    }
+    return area_;
+}
+
+template <typename Overlaps, typename Visit>
+void spatial_index::traverse(Overlaps&& overlaps, Visit&& visit) {
+    if (nodes_.empty()) {
+        return;
+    }
+    stack_.clear();
+    stack_.push_back(0);
+    while (!stack_.empty()) {
+        const bvh_node& node = nodes_[stack_.back()];
+        stack_.pop_back();
+        if (!overlaps(node.box)) {
+            continue;
+        }
+        if (node.count == 0) {
+            stack_.push_back(node.first);
+            stack_.push_back(node.first + 1);
+            continue;
+        }
+        for (index_type k = node.first; k < node.first + node.count; ++k) {
+            if (overlaps(boxes_[k])) {
+                visit(k);
+            }
+        }
+    }
+}
+
+std::span<const entt::entity> spatial_index::query(const frustum& a_frustum) & {
+    result_.clear();
+    traverse(
+        [&a_frustum](const aabb& box) { return overlaps(a_frustum, box); },
+        [this](index_type k) { result_.push_back(entities_[k]); }
+    );
+    return result_;
+}
+
+std::span<const entt::entity> spatial_index::query(const bounding_sphere& sphere) & {
+    result_.clear();
+    traverse(
+        [&sphere](const aabb& box) { return overlaps(sphere, box); },
+        [this](index_type k) { result_.push_back(entities_[k]); }
+    );
+    return result_;
+}
+
+std::span<const entt::entity> spatial_index::query(const ray& a_ray) & {
+    result_.clear();
+    hits_.clear();
+    const glm::vec3 inverse_direction = 1.0f / a_ray.direction;
+    traverse(
+        [&](const aabb& box) { return entry_distance(a_ray, inverse_direction, box).has_value(); },
+        [&](index_type k) {
+            const float distance = entry_distance(a_ray, inverse_direction, boxes_[k]).value();
+            hits_.emplace_back(distance, entities_[k]);
+        }
+    );
+    std::ranges::sort(hits_, {}, [](const auto& hit) { return hit.first; });
+    std::ranges::transform(hits_, std::back_inserter(result_), [](const auto& hit) { return hit.second; });
+    return result_;
+}
+
+} // namespace sl::game
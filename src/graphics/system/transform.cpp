@@ -3,11 +3,38 @@
 //
 
 #include "sl/game/graphics/system/transform.hpp"
+#include "sl/game/update/dirty.hpp"
 #include "sl/game/update/system.hpp"
 
 #include <sl/meta/assert.hpp>
 
+#include <span>
+#include <vector>
+
 namespace sl::game {
+namespace {
+
+// below that a level is processed on the calling thread only
+constexpr std::size_t level_min_grain = 256;
+
+struct level_chunk {
+    std::vector<entt::entity> next_level;
+    // emplacing into storage is not thread-safe, so new transforms are emplaced after the level is done
+    std::vector<std::pair<entt::entity, transform>> new_transforms;
+    // neither is emitting signals, so observed in-place changes are patched after the level is done
+    std::vector<entt::entity> changed_transforms;
+};
+
+dirty_subtrees<local_transform>& local_transform_dirty_subtrees(ecs::layer& layer) {
+    using ptr_type = dirty_subtrees<local_transform>::ptr_type;
+    if (auto* maybe_dirty = layer.registry.template try_get<ptr_type>(layer.root); maybe_dirty != nullptr) {
+        return **maybe_dirty;
+    }
+    return *layer.registry.template emplace<ptr_type>(layer.root, dirty_subtrees<local_transform>::make(layer));
+}
+
+} // namespace
+
 namespace detail {
 
 void local_transform_system(ecs::layer& layer, entt::entity entity, time_point time_point [[maybe_unused]]) {
@@ -33,6 +60,10 @@ void local_transform_system(ecs::layer& layer, entt::entity entity, time_point t
         })
         .map([&](transform new_tf) {
             layer.registry.template emplace_or_replace<transform>(entity, new_tf);
+            if (auto* maybe_world_matrix = layer.registry.template try_get<world_matrix>(entity);
+                maybe_world_matrix != nullptr) {
+                *maybe_world_matrix = world_matrix::from(new_tf);
+            }
 
             if (node_component == nullptr) {
                 return;
@@ -51,7 +82,100 @@ void local_transform_system(ecs::layer& layer, entt::entity entity, time_point t
 } // namespace detail
 
 void local_transform_system(ecs::layer& layer, time_point time_point) {
-    tree_update_system(tree_update_order::TOP_DOWN, layer, detail::local_transform_system, time_point);
+    const std::span<const entt::entity> roots = local_transform_dirty_subtrees(layer).release_roots();
+    tree_update_system(tree_update_order::TOP_DOWN, layer, roots, detail::local_transform_system, time_point);
+}
+
+void local_transform_system(ecs::layer& layer, time_point time_point [[maybe_unused]], worker_pool& workers) {
+    // storages are created lazily by registry, which is not thread-safe, so get them upfront
+    auto& local_tf_storage = layer.registry.template storage<local_transform>();
+    auto& tf_storage = layer.registry.template storage<transform>();
+    auto& world_matrix_storage = layer.registry.template storage<world_matrix>();
+    const auto& node_storage = layer.registry.template storage<node>();
+    // patching is skipped entirely if nobody listens
+    const bool is_transform_observed = !layer.registry.template on_update<transform>().empty();
+
+    const auto process = [&](level_chunk& chunk, entt::entity entity) {
+        const node* node_component = node_storage.contains(entity) ? &node_storage.get(entity) : nullptr;
+        if (node_component != nullptr) {
+            const auto& children = node_component->children;
+            chunk.next_level.insert(chunk.next_level.end(), children.begin(), children.end());
+        }
+
+        if (!local_tf_storage.contains(entity)) {
+            DEBUG_ASSERT(
+                !tf_storage.contains(entity), "all transforms have to have local_transform component in tree structure"
+            );
+            return;
+        }
+        local_transform& local_tf = local_tf_storage.get(entity);
+        local_tf.release()
+            .map([&](const transform& changed_local_tf) -> transform {
+                const entt::entity parent = node_component == nullptr ? entt::null : node_component->parent;
+                if (parent == entt::null) { // root
+                    return changed_local_tf;
+                }
+                // parent belongs to the previous level, which is complete
+                ASSERT(tf_storage.contains(parent), "parent has to have transform", entity, parent);
+                return combine(tf_storage.get(parent), changed_local_tf);
+            })
+            .map([&](transform new_tf) {
+                if (tf_storage.contains(entity)) {
+                    tf_storage.get(entity) = new_tf;
+                    if (is_transform_observed) {
+                        chunk.changed_transforms.push_back(entity);
+                    }
+                } else {
+                    chunk.new_transforms.emplace_back(entity, new_tf);
+                }
+                if (world_matrix_storage.contains(entity)) {
+                    world_matrix_storage.get(entity) = world_matrix::from(new_tf);
+                }
+
+                if (node_component == nullptr) {
+                    return;
+                }
+                // every child has a single parent, so no other chunk touches these
+                for (const entt::entity child_entity : node_component->children) {
+                    if (local_tf_storage.contains(child_entity)) {
+                        local_tf_storage.get(child_entity).set_dirty(true);
+                    }
+                }
+            });
+    };
+
+    // dirty subtrees are disjoint and their parents are up to date, so they can share levels
+    const std::span<const entt::entity> roots = local_transform_dirty_subtrees(layer).release_roots();
+    std::vector<entt::entity> level{ roots.begin(), roots.end() };
+    std::vector<level_chunk> chunks;
+
+    while (!level.empty()) {
+        const std::size_t grain = workers.grain_for(level.size(), level_min_grain);
+        chunks.resize(worker_pool::chunk_count(level.size(), grain));
+        for (level_chunk& chunk : chunks) {
+            chunk.next_level.clear();
+            chunk.new_transforms.clear();
+            chunk.changed_transforms.clear();
+        }
+
+        workers.parallel_for(level.size(), grain, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+            level_chunk& chunk = chunks[chunk_index];
+            for (const entt::entity entity : std::span{ level }.subspan(begin, end - begin)) {
+                process(chunk, entity);
+            }
+        });
+
+        level.clear();
+        for (level_chunk& chunk : chunks) {
+            for (const auto& [entity, new_tf] : chunk.new_transforms) {
+                layer.registry.template emplace<transform>(entity, new_tf);
+            }
+            for (const entt::entity entity : chunk.changed_transforms) {
+                layer.registry.template patch<transform>(entity);
+            }
+            level.insert(level.end(), chunk.next_level.begin(), chunk.next_level.end());
+        }
+    }
 }
 
 } // namespace sl::game
@@ -0,0 +1,167 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/texture_array.hpp"
+#include "sl/game/detail/log.hpp"
+
+#include <sl/meta/assert.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace sl::game {
+namespace {
+
+GLsizei mip_level_count(glm::uvec2 size) {
+    return static_cast<GLsizei>(std::bit_width(std::max({ size.x, size.y, 1u })));
+}
+
+} // namespace
+
+pooled_layer& pooled_layer::operator=(pooled_layer&& other) noexcept {
+    if (this != &other) {
+        if (arrays_ != nullptr) {
+            arrays_->remove(location_);
+        }
+        arrays_ = std::move(other.arrays_);
+        location_ = other.location_;
+    }
+    return *this;
+}
+
+pooled_layer::~pooled_layer() {
+    if (arrays_ != nullptr) {
+        arrays_->remove(location_);
+    }
+}
+
+texture_arrays& texture_arrays::of(ecs::layer& layer) {
+    if (auto* maybe_arrays = layer.registry.try_get<ptr_type>(layer.root); maybe_arrays != nullptr) {
+        return **maybe_arrays;
+    }
+    return *layer.registry.emplace<ptr_type>(layer.root, make());
+}
+
+texture_arrays::~texture_arrays() {
+    for (array& an_array : arrays_) {
+        if (an_array.texture != 0) {
+            glDeleteTextures(1, &an_array.texture);
+        }
+    }
+}
+
+meta::maybe<pooled_layer> texture_arrays::add(glm::uvec2 size, std::span<const std::byte> rgba) & {
+    ASSERT(rgba.size() == std::size_t{ size.x } * size.y * 4, "expected rgba8 image", size.x, size.y, rgba.size());
+
+    auto it = std::ranges::find(arrays_, size, &array::size);
+    if (it == arrays_.end()) {
+        if (arrays_.size() == max_array_count) {
+            log::debug("[texture_arrays] no array left for size={}x{}", size.x, size.y);
+            return meta::null;
+        }
+        it = arrays_.insert(arrays_.end(), array{ .size = size });
+    }
+    array& an_array = *it;
+
+    std::uint32_t layer = 0;
+    if (!an_array.free_layers.empty()) {
+        layer = an_array.free_layers.back();
+        an_array.free_layers.pop_back();
+    } else if (an_array.layer_count < an_array.layer_capacity
+               || reserve(an_array, std::max(an_array.layer_capacity * 2, initial_layer_capacity))) {
+        layer = an_array.layer_count++;
+    } else {
+        log::debug("[texture_arrays] array of size={}x{} is full", size.x, size.y);
+        return meta::null;
+    }
+
+    glTextureSubImage3D(
+        an_array.texture,
+        0,
+        0,
+        0,
+        static_cast<GLint>(layer),
+        static_cast<GLsizei>(size.x),
+        static_cast<GLsizei>(size.y),
+        1,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        rgba.data()
+    );
+    an_array.is_dirty = true;
+    return pooled_layer{
+        shared_from_this(),
+        texture_layer{ .array = static_cast<std::uint32_t>(it - arrays_.begin()), .layer = layer },
+    };
+}
+
+void texture_arrays::remove(texture_layer location) & {
+    array& an_array = arrays_.at(location.array);
+    ASSERT(location.layer < an_array.layer_count, "layer out of array", location.array, location.layer);
+    an_array.free_layers.push_back(location.layer);
+}
+
+void texture_arrays::bind(std::uint32_t first_unit) & {
+    for (std::uint32_t array_index = 0; array_index < arrays_.size(); ++array_index) {
+        array& an_array = arrays_[array_index];
+        if (std::exchange(an_array.is_dirty, false)) {
+            glGenerateTextureMipmap(an_array.texture);
+        }
+        glBindTextureUnit(first_unit + array_index, an_array.texture);
+    }
+}
+
+bool texture_arrays::reserve(array& an_array, std::uint32_t layer_capacity) {
+    GLint max_layer_count = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layer_count);
+    layer_capacity = std::min(layer_capacity, static_cast<std::uint32_t>(std::max(max_layer_count, 0)));
+    if (layer_capacity <= an_array.layer_capacity) {
+        return false;
+    }
+
+    GLuint texture = 0;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+    glTextureStorage3D(
+        texture,
+        mip_level_count(an_array.size),
+        GL_RGBA8,
+        static_cast<GLsizei>(an_array.size.x),
+        static_cast<GLsizei>(an_array.size.y),
+        static_cast<GLsizei>(layer_capacity)
+    );
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (an_array.texture != 0) {
+        // only the base level, mipmaps are regenerated on the next bind
+        glCopyImageSubData(
+            an_array.texture,
+            GL_TEXTURE_2D_ARRAY,
+            0,
+            0,
+            0,
+            0,
+            texture,
+            GL_TEXTURE_2D_ARRAY,
+            0,
+            0,
+            0,
+            0,
+            static_cast<GLsizei>(an_array.size.x),
+            static_cast<GLsizei>(an_array.size.y),
+            static_cast<GLsizei>(an_array.layer_count)
+        );
+        glDeleteTextures(1, &an_array.texture);
+        an_array.is_dirty = true;
+    }
+    log::trace("[texture_arrays] size={}x{} layer_capacity={}", an_array.size.x, an_array.size.y, layer_capacity);
+    an_array.texture = texture;
+    an_array.layer_capacity = layer_capacity;
+    return true;
+}
+
+} // namespace sl::game
@@ -0,0 +1,222 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/render/light/cluster.hpp"
+#include "sl/game/detail/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace sl::game::render {
+namespace {
+
+// below that lights are assigned on the calling thread only
+constexpr std::size_t assign_min_grain = 256;
+
+// orthographic projections may have near plane behind the camera, exponential slicing needs it in front
+constexpr float min_near = 0.01f;
+
+glm::vec3 unproject(const glm::mat4& inverse_projection, const glm::vec3& ndc) {
+    const glm::vec4 view = inverse_projection * glm::vec4{ ndc, 1.0f };
+    return glm::vec3{ view } / view.w;
+}
+
+bool overlaps(const aabb& box, const glm::vec3& center, float radius) {
+    const glm::vec3 closest = glm::clamp(center, box.min, box.max);
+    const glm::vec3 delta = closest - center;
+    return glm::dot(delta, delta) <= radius * radius;
+}
+
+std::uint32_t tile(float ndc, std::uint32_t size) {
+    const float position = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(size));
+    return static_cast<std::uint32_t>(std::clamp(position, 0.0f, static_cast<float>(size - 1)));
+}
+
+} // namespace
+
+void clustered_lights::assign(
+    std::span<const point_light_element> points,
+    std::span<const spot_light_element> spots,
+    const camera_frame& camera_frame,
+    worker_pool* workers
+) {
+    update_cluster_bounds(camera_frame.projection);
+
+    const std::size_t light_count = points.size() + spots.size();
+    // matches chunking of parallel_for, so that every chunk has its own output
+    chunks_.resize(
+        workers == nullptr
+            ? 1
+            : worker_pool::chunk_count(light_count, workers->grain_for(light_count, assign_min_grain))
+    );
+    const auto assign_chunk = [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+        std::vector<light_in_cluster>& chunk = chunks_[chunk_index];
+        chunk.clear();
+        for (std::size_t i = begin; i < end; ++i) {
+            const bool is_point = i < points.size();
+            const glm::vec3 position = is_point ? points[i].position : spots[i - points.size()].position;
+            const float radius = is_point ? points[i].radius() : spots[i - points.size()].radius();
+            const glm::vec3 view_position{ camera_frame.view * glm::vec4{ position, 1.0f } };
+            assign_light(chunk, static_cast<std::uint32_t>(i), view_position, radius, camera_frame.projection);
+        }
+    };
+    parallel_for(workers, light_count, assign_min_grain, assign_chunk);
+
+    // counting sort by cluster, chunks are in light order, so are lights within a cluster
+    clusters_.assign(grid_.size(), light_cluster_element{});
+    for (const auto& chunk : chunks_) {
+        for (const auto [cluster, light] : chunk) {
+            ++(light < points.size() ? clusters_[cluster].point_count : clusters_[cluster].spot_count);
+        }
+    }
+    std::uint32_t offset = 0;
+    for (light_cluster_element& cluster : clusters_) {
+        cluster.point_offset = offset;
+        offset += std::exchange(cluster.point_count, 0);
+        cluster.spot_offset = offset;
+        offset += std::exchange(cluster.spot_count, 0);
+    }
+    indices_.resize(offset);
+    for (const auto& chunk : chunks_) {
+        for (const auto [cluster_index, light] : chunk) {
+            light_cluster_element& cluster = clusters_[cluster_index];
+            if (light < points.size()) {
+                indices_[cluster.point_offset + cluster.point_count++] = light;
+            } else {
+                const auto spot = light - static_cast<std::uint32_t>(points.size());
+                indices_[cluster.spot_offset + cluster.spot_count++] = spot;
+            }
+        }
+    }
+}
+
+void clustered_lights::upload(
+    ecs::layer& layer,
+    const basis& world,
+    const camera_frame& camera_frame,
+    worker_pool* workers
+) {
+    point_mirror_ = &ssbo_mirror<point_light_element>::of(layer);
+    spot_mirror_ = &ssbo_mirror<spot_light_element>::of(layer);
+    point_mirror_->update(world);
+    spot_mirror_->update(world);
+
+    assign(point_mirror_->elements(), spot_mirror_->elements(), camera_frame, workers);
+
+    cluster_ssbo_.upload(clusters_);
+    index_ssbo_.upload(indices_);
+}
+
+void clustered_lights::update_cluster_bounds(const glm::mat4& projection) {
+    if (bounds_projection_.has_value() && bounds_projection_.value() == projection) {
+        return;
+    }
+    bounds_projection_.emplace(projection);
+
+    const glm::mat4 inverse_projection = glm::inverse(projection);
+    near_ = std::max(-unproject(inverse_projection, glm::vec3{ 0.0f, 0.0f, -1.0f }).z, min_near);
+    far_ = std::max(-unproject(inverse_projection, glm::vec3{ 0.0f, 0.0f, 1.0f }).z, near_ * 2.0f);
+    depth_scale_ = static_cast<float>(grid_.z) / std::log(far_ / near_);
+    log::debug("[clustered_lights] near={} far={} grid={}x{}x{}", near_, far_, grid_.x, grid_.y, grid_.z);
+
+    const auto slice_depth = [this](std::uint32_t z) {
+        return z == 0 ? 0.0f : near_ * std::pow(far_ / near_, static_cast<float>(z) / static_cast<float>(grid_.z));
+    };
+
+    cluster_bounds_.resize(grid_.size());
+    for (std::uint32_t y = 0; y < grid_.y; ++y) {
+        for (std::uint32_t x = 0; x < grid_.x; ++x) {
+            // corner rays of the tile, from near to far plane
+            std::array<std::pair<glm::vec3, glm::vec3>, 4> rays;
+            for (std::uint32_t corner = 0; corner < rays.size(); ++corner) {
+                const glm::vec2 ndc{
+                    -1.0f + 2.0f * static_cast<float>(x + (corner & 1u)) / static_cast<float>(grid_.x),
+                    -1.0f + 2.0f * static_cast<float>(y + (corner >> 1u)) / static_cast<float>(grid_.y),
+                };
+                rays[corner] = {
+                    unproject(inverse_projection, glm::vec3{ ndc, -1.0f }),
+                    unproject(inverse_projection, glm::vec3{ ndc, 1.0f }),
+                };
+            }
+
+            for (std::uint32_t z = 0; z < grid_.z; ++z) {
+                aabb box;
+                for (const float depth : { slice_depth(z), slice_depth(z + 1) }) {
+                    for (const auto& [ray_near, ray_far] : rays) {
+                        const float t = (-depth - ray_near.z) / (ray_far.z - ray_near.z);
+                        box.extend(ray_near + (ray_far - ray_near) * t);
+                    }
+                }
+                cluster_bounds_[grid_.index(x, y, z)] = box;
+            }
+        }
+    }
+}
+
+void clustered_lights::assign_light(
+    std::vector<light_in_cluster>& out,
+    std::uint32_t light,
+    const glm::vec3& view_position,
+    float radius,
+    const glm::mat4& projection
+) const {
+    const float depth = -view_position.z;
+    if (radius <= 0.0f || depth + radius < 0.0f || depth - radius > far_) {
+        return;
+    }
+
+    std::uint32_t x_begin = 0;
+    std::uint32_t x_end = grid_.x - 1;
+    std::uint32_t y_begin = 0;
+    std::uint32_t y_end = grid_.y - 1;
+    if (std::isfinite(radius) && depth - radius > near_) {
+        // screen rectangle of the sphere's box, only valid if the box is in front of the camera
+        glm::vec2 ndc_min{ std::numeric_limits<float>::max() };
+        glm::vec2 ndc_max{ std::numeric_limits<float>::lowest() };
+        for (std::uint32_t corner = 0; corner < 8; ++corner) {
+            const glm::vec3 offset{
+                (corner & 1u) != 0 ? radius : -radius,
+                (corner & 2u) != 0 ? radius : -radius,
+                (corner & 4u) != 0 ? radius : -radius,
+            };
+            const glm::vec4 clip = projection * glm::vec4{ view_position + offset, 1.0f };
+            const glm::vec2 ndc = glm::vec2{ clip } / clip.w;
+            ndc_min = glm::min(ndc_min, ndc);
+            ndc_max = glm::max(ndc_max, ndc);
+        }
+        if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f) {
+            return;
+        }
+        x_begin = tile(ndc_min.x, grid_.x);
+        x_end = tile(ndc_max.x, grid_.x);
+        y_begin = tile(ndc_min.y, grid_.y);
+        y_end = tile(ndc_max.y, grid_.y);
+    }
+
+    const std::uint32_t z_begin = std::isfinite(radius) ? slice(depth - radius) : 0;
+    const std::uint32_t z_end = std::isfinite(radius) ? slice(depth + radius) : grid_.z - 1;
+    for (std::uint32_t z = z_begin; z <= z_end; ++z) {
+        for (std::uint32_t y = y_begin; y <= y_end; ++y) {
+            for (std::uint32_t x = x_begin; x <= x_end; ++x) {
+                const std::uint32_t cluster = grid_.index(x, y, z);
+                if (!std::isfinite(radius) || overlaps(cluster_bounds_[cluster], view_position, radius)) {
+                    out.push_back(light_in_cluster{ .cluster = cluster, .light = light });
+                }
+            }
+        }
+    }
+}
+
+std::uint32_t clustered_lights::slice(float depth) const {
+    if (depth <= near_) {
+        return 0;
+    }
+    const float position = std::floor(std::log(depth / near_) * depth_scale_);
+    return static_cast<std::uint32_t>(std::clamp(position, 0.0f, static_cast<float>(grid_.z - 1)));
+}
+
+} // namespace sl::game::render
@@ -0,0 +1,148 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/update/flat_tree.hpp"
+
+#include <sl/meta/assert.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+namespace sl::game {
+
+flat_tree::flat_tree(entt::entity root) {
+    elements_.push_back(element{ .entity = root, .parent = entt::null, .subtree_size = 1 });
+    index_by_entity_.emplace(root, 0);
+}
+
+meta::maybe<entt::entity> flat_tree::parent(entt::entity entity) const {
+    const auto index_it = index_by_entity_.find(entity);
+    if (index_it == index_by_entity_.end()) {
+        return meta::null;
+    }
+    const entt::entity parent_entity = elements_[index_it->second].parent;
+    if (parent_entity == entt::null) {
+        return meta::null;
+    }
+    return parent_entity;
+}
+
+bool flat_tree::attach_child(entt::entity parent_entity, entt::entity child_entity) {
+    const auto parent_it = index_by_entity_.find(parent_entity);
+    if (parent_it == index_by_entity_.end() || child_entity == root()) {
+        return false;
+    }
+    const index_type parent_index = parent_it->second;
+    // end of the parent's subtree, before anything is moved
+    const index_type to = parent_index + elements_[parent_index].subtree_size;
+
+    const auto child_it = index_by_entity_.find(child_entity);
+    if (child_it == index_by_entity_.end()) {
+        elements_.insert(
+            elements_.begin() + to, element{ .entity = child_entity, .parent = parent_entity, .subtree_size = 1 }
+        );
+        reindex(to, static_cast<index_type>(elements_.size()));
+        resize_subtrees(parent_entity, 1);
+        return true;
+    }
+
+    const index_type child_index = child_it->second;
+    element& child = elements_[child_index];
+    if (child.parent == parent_entity) {
+        return true;
+    }
+    const index_type child_size = child.subtree_size;
+    if (parent_index >= child_index && parent_index < child_index + child_size) {
+        return false;
+    }
+
+    if (child.parent != entt::null) {
+        resize_subtrees(child.parent, -static_cast<std::int64_t>(child_size));
+    }
+    const index_type moved_index = move(child_index, child_index + child_size, to);
+    elements_[moved_index].parent = parent_entity;
+    resize_subtrees(parent_entity, child_size);
+    return true;
+}
+
+bool flat_tree::detach_child(entt::entity child_entity) {
+    const auto child_it = index_by_entity_.find(child_entity);
+    if (child_it == index_by_entity_.end()) {
+        return false;
+    }
+    const index_type child_index = child_it->second;
+    element& child = elements_[child_index];
+    if (child.parent == entt::null) {
+        return child_index != 0;
+    }
+
+    const index_type child_size = child.subtree_size;
+    resize_subtrees(child.parent, -static_cast<std::int64_t>(child_size));
+    child.parent = entt::null;
+    std::ignore = move(child_index, child_index + child_size, static_cast<index_type>(elements_.size()));
+    return true;
+}
+
+std::size_t flat_tree::erase(entt::entity entity) {
+    const auto index_it = index_by_entity_.find(entity);
+    if (index_it == index_by_entity_.end() || index_it->second == 0) {
+        return 0;
+    }
+    const index_type index = index_it->second;
+    const element& erased = elements_[index];
+    const index_type erased_size = erased.subtree_size;
+    if (erased.parent != entt::null) {
+        resize_subtrees(erased.parent, -static_cast<std::int64_t>(erased_size));
+    }
+
+    for (index_type i = index; i < index + erased_size; ++i) {
+        index_by_entity_.erase(elements_[i].entity);
+    }
+    elements_.erase(elements_.begin() + index, elements_.begin() + index + erased_size);
+    reindex(index, static_cast<index_type>(elements_.size()));
+    return erased_size;
+}
+
+flat_tree::index_type flat_tree::first_child(index_type index) const {
+    return elements_[index].subtree_size > 1 ? index + 1 : npos;
+}
+
+flat_tree::index_type flat_tree::next_sibling(index_type index) const {
+    const element& current = elements_[index];
+    if (current.parent == entt::null) {
+        return npos;
+    }
+    const index_type parent_index = index_of(current.parent);
+    const index_type sibling_index = index + current.subtree_size;
+    return sibling_index < parent_index + elements_[parent_index].subtree_size ? sibling_index : npos;
+}
+
+void flat_tree::resize_subtrees(entt::entity entity, std::int64_t delta) {
+    while (entity != entt::null) {
+        element& current = elements_[index_of(entity)];
+        current.subtree_size = static_cast<index_type>(static_cast<std::int64_t>(current.subtree_size) + delta);
+        entity = current.parent;
+    }
+}
+
+flat_tree::index_type flat_tree::move(index_type begin, index_type end, index_type to) {
+    DEBUG_ASSERT(to <= begin || to >= end);
+    const auto elements_begin = elements_.begin();
+    if (to >= end) {
+        std::rotate(elements_begin + begin, elements_begin + end, elements_begin + to);
+        reindex(begin, to);
+        return to - (end - begin);
+    }
+    std::rotate(elements_begin + to, elements_begin + begin, elements_begin + end);
+    reindex(to, end);
+    return to;
+}
+
+void flat_tree::reindex(index_type begin, index_type end) {
+    for (index_type i = begin; i < end; ++i) {
+        index_by_entity_.insert_or_assign(elements_[i].entity, i);
+    }
+}
+
+} // namespace sl::game
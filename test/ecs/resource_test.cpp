@@ -0,0 +1,177 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/ecs/resource.hpp"
+
+#include <sl/exec/algo/make/result.hpp>
+#include <sl/meta/storage/unique_string_convenience.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sl::ecs {
+namespace {
+
+using meta::operator""_ufs;
+using meta::operator""_us;
+
+struct resource_index_test : ::testing::Test {
+    meta::unique_string_storage uss{ meta::unique_string_storage::init_type{} };
+    detail::resource_index<int> index{};
+};
+
+TEST_F(resource_index_test, looksUpPublished) {
+    const meta::unique_string a = "a"_us(uss);
+    const meta::unique_string b = "b"_us(uss);
+    EXPECT_FALSE(index.lookup(a).has_value());
+
+    index.publish(a, 1);
+    index.publish(b, 2);
+    EXPECT_EQ(index.lookup(a).value(), 1);
+    EXPECT_EQ(index.lookup(b).value(), 2);
+
+    index.publish(a, 3);
+    EXPECT_EQ(index.lookup(a).value(), 3);
+}
+
+TEST_F(resource_index_test, erasedIsNotFound) {
+    const meta::unique_string a = "a"_us(uss);
+    const meta::unique_string b = "b"_us(uss);
+    index.publish(a, 1);
+    index.publish(b, 2);
+
+    index.erase(a);
+    EXPECT_FALSE(index.lookup(a).has_value());
+    EXPECT_EQ(index.lookup(b).value(), 2);
+}
+
+TEST_F(resource_index_test, readersSeeEveryPublishedId) {
+    constexpr int id_count = 1000;
+    std::vector<meta::unique_string> ids;
+    for (int i = 0; i < id_count; ++i) {
+        ids.push_back("id.{}"_ufs(i)(uss));
+    }
+
+    // ids are published in order, so a reader that found i has to find every id before it
+    std::atomic<int> published_count{ 0 };
+    std::atomic<bool> is_consistent{ true };
+    std::vector<std::thread> readers;
+    for (int reader = 0; reader < 4; ++reader) {
+        readers.emplace_back([&] {
+            while (published_count.load(std::memory_order_acquire) < id_count) {
+                const int known_count = published_count.load(std::memory_order_acquire);
+                for (int i = 0; i < known_count; ++i) {
+                    const auto maybe_value = index.lookup(ids[i]);
+                    if (!maybe_value.has_value() || maybe_value.value() != i) {
+                        is_consistent.store(false, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+    for (int i = 0; i < id_count; ++i) {
+        index.publish(ids[i], i);
+        published_count.store(i + 1, std::memory_order_release);
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_TRUE(is_consistent.load());
+}
+
+// stands for a value owning a GL object, counts destruction of the instance it was moved to last
+struct owned_value {
+    owned_value(int* a_destroy_count, std::size_t a_byte_size)
+        : destroy_count{ a_destroy_count }, byte_size{ a_byte_size } {}
+    owned_value(owned_value&& other) noexcept
+        : destroy_count{ std::exchange(other.destroy_count, nullptr) }, byte_size{ other.byte_size } {}
+    owned_value& operator=(owned_value&& other) noexcept {
+        std::swap(destroy_count, other.destroy_count);
+        byte_size = other.byte_size;
+        return *this;
+    }
+    ~owned_value() {
+        if (destroy_count != nullptr) {
+            ++*destroy_count;
+        }
+    }
+
+    int* destroy_count;
+    std::size_t byte_size;
+};
+
+struct resource_eviction_test : ::testing::Test {
+    using reference_type = resource<owned_value>::reference_type;
+
+    static constexpr std::size_t value_byte_size = sizeof(owned_value) + 100;
+
+    meta::maybe<reference_type> require(meta::unique_string id) {
+        meta::maybe<reference_type> result;
+        exec::coro_schedule(executor, require_into(id, result));
+        while (executor.execute_batch() > 0) {}
+        return result;
+    }
+
+    exec::async<void> require_into(meta::unique_string id, meta::maybe<reference_type>& result) {
+        using exec::operator co_await;
+        result = co_await values->require(id, exec::value_as_signal(owned_value{ &destroy_count, 100 }));
+    }
+
+    meta::unique_string_storage uss{ meta::unique_string_storage::init_type{} };
+    exec::manual_executor executor{};
+    resource<owned_value>::ptr_type values = resource<owned_value>::make(executor);
+    int destroy_count = 0;
+};
+
+TEST_F(resource_eviction_test, evictsLeastRecentlyUsedAndDestroysIt) {
+    const meta::unique_string a = "a"_us(uss);
+    const meta::unique_string b = "b"_us(uss);
+    const meta::unique_string c = "c"_us(uss);
+    values->set_budget(2 * value_byte_size);
+
+    ASSERT_TRUE(require(a).has_value());
+    ASSERT_TRUE(require(b).has_value());
+    // lookup marks a as used, so that b is the least recently used one
+    ASSERT_TRUE(values->lookup(a).has_value());
+    ASSERT_TRUE(require(c).has_value());
+
+    EXPECT_EQ(destroy_count, 1);
+    EXPECT_FALSE(values->lookup(b).has_value());
+    EXPECT_TRUE(values->lookup(a).has_value());
+    EXPECT_TRUE(values->lookup(c).has_value());
+    EXPECT_EQ(values->stats().evict_count, 1);
+    EXPECT_EQ(values->stats().byte_size, 2 * value_byte_size);
+}
+
+TEST_F(resource_eviction_test, retainedIsNotEvicted) {
+    const meta::unique_string a = "a"_us(uss);
+    const meta::unique_string b = "b"_us(uss);
+    const meta::unique_string c = "c"_us(uss);
+    values->set_budget(value_byte_size);
+
+    meta::maybe<reference_type> a_reference = require(a);
+    ASSERT_TRUE(a_reference.has_value());
+    ASSERT_TRUE(require(b).has_value());
+
+    // a is retained and b was just loaded
+    EXPECT_EQ(destroy_count, 0);
+    EXPECT_TRUE(values->lookup(a).has_value());
+    EXPECT_TRUE(values->lookup(b).has_value());
+
+    a_reference = meta::null;
+    ASSERT_TRUE(require(c).has_value());
+
+    EXPECT_EQ(destroy_count, 2);
+    EXPECT_FALSE(values->lookup(a).has_value());
+    EXPECT_FALSE(values->lookup(b).has_value());
+    EXPECT_TRUE(values->lookup(c).has_value());
+}
+
+} // namespace
+} // namespace sl::ecs
@@ -0,0 +1,93 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/engine/worker_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+TEST(worker_pool, visitsEveryIndexOnce) {
+    worker_pool workers{ 4 };
+    constexpr std::size_t size = 100'003;
+    std::vector<std::atomic<int>> visits(size);
+
+    workers.parallel_for(size, 1000, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            visits[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    for (std::size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(visits[i].load(), 1) << i;
+    }
+}
+
+TEST(worker_pool, chunksMatchGrain) {
+    worker_pool workers{ 3 };
+    constexpr std::size_t size = 10;
+    constexpr std::size_t grain = 3;
+    std::vector<std::size_t> chunk_sizes(worker_pool::chunk_count(size, grain));
+
+    workers.parallel_for(size, grain, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+        EXPECT_EQ(begin, chunk_index * grain);
+        chunk_sizes[chunk_index] = end - begin;
+    });
+
+    EXPECT_EQ(chunk_sizes, (std::vector<std::size_t>{ 3, 3, 3, 1 }));
+}
+
+TEST(worker_pool, runsConsecutiveJobs) {
+    worker_pool workers{ 4 };
+    for (std::size_t size = 0; size < 64; ++size) {
+        std::vector<std::size_t> values(size);
+        workers.parallel_for(size, 1, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                values[i] = i;
+            }
+        });
+        std::vector<std::size_t> expected(size);
+        std::iota(expected.begin(), expected.end(), std::size_t{ 0 });
+        ASSERT_EQ(values, expected);
+    }
+}
+
+TEST(worker_pool, worksWithoutThreads) {
+    worker_pool workers{ 0 };
+    EXPECT_EQ(workers.concurrency(), 1);
+
+    std::size_t sum = 0;
+    workers.parallel_for(10, 4, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            sum += i;
+        }
+    });
+    EXPECT_EQ(sum, 45);
+}
+
+TEST(worker_pool, parallelForWithoutPoolRunsOneChunk) {
+    std::size_t call_count = 0;
+    parallel_for(nullptr, 5000, 16, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+        EXPECT_EQ(chunk_index, 0);
+        EXPECT_EQ(begin, 0);
+        EXPECT_EQ(end, 5000);
+        ++call_count;
+    });
+    EXPECT_EQ(call_count, 1);
+}
+
+TEST(worker_pool, grainForRespectsMinimum) {
+    worker_pool workers{ 3 };
+    EXPECT_EQ(workers.grain_for(10, 64), 64);
+    EXPECT_GE(workers.grain_for(1'000'000, 64) * workers.concurrency() * 4, 1'000'000);
+}
+
+} // namespace
+} // namespace sl::game
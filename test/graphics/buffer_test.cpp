@@ -0,0 +1,99 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/buffer.hpp"
+#include "sl/game/render/light/component.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+struct ssbo_capacity_policy_test : ::testing::Test {
+    ssbo_capacity_policy policy{};
+
+    // fits size until capacity changes or shrink_delay fits pass, returns the amount of fits
+    std::size_t fit_until_change(std::size_t size) {
+        for (std::size_t i = 1; i <= ssbo_capacity_policy::shrink_delay; ++i) {
+            if (policy.fit(size)) {
+                return i;
+            }
+        }
+        return 0;
+    }
+};
+
+TEST_F(ssbo_capacity_policy_test, growsToPowerOfTwo) {
+    EXPECT_TRUE(policy.fit(0));
+    EXPECT_EQ(policy.capacity, 1);
+    EXPECT_TRUE(policy.fit(5));
+    EXPECT_EQ(policy.capacity, 8);
+    EXPECT_FALSE(policy.fit(8));
+    EXPECT_TRUE(policy.fit(9));
+    EXPECT_EQ(policy.capacity, 16);
+}
+
+TEST_F(ssbo_capacity_policy_test, shrinksAfterDelay) {
+    ASSERT_TRUE(policy.fit(1000));
+    ASSERT_EQ(policy.capacity, 1024);
+
+    EXPECT_EQ(fit_until_change(10), ssbo_capacity_policy::shrink_delay);
+    EXPECT_EQ(policy.capacity, 32);
+}
+
+TEST_F(ssbo_capacity_policy_test, oscillationDoesNotShrink) {
+    ASSERT_TRUE(policy.fit(1000));
+    for (std::size_t i = 0; i < ssbo_capacity_policy::shrink_delay * 2; ++i) {
+        ASSERT_FALSE(policy.fit(i % 2 == 0 ? 100 : 600));
+    }
+    EXPECT_EQ(policy.capacity, 1024);
+}
+
+TEST_F(ssbo_capacity_policy_test, doesNotReportUnchangedCapacity) {
+    ASSERT_TRUE(policy.fit(0));
+    ASSERT_EQ(policy.capacity, 1);
+
+    // empty buffer keeps its single element, so the shrink is a no-op
+    EXPECT_EQ(fit_until_change(0), 0);
+    EXPECT_EQ(policy.capacity, 1);
+}
+
+TEST(fill_ssbo, parallelMatchesSerial) {
+    ecs::layer layer{};
+    const basis world{};
+    std::vector<entt::entity> entities;
+    for (int i = 0; i < 5000; ++i) {
+        const entt::entity entity = layer.registry.create();
+        entities.push_back(entity);
+        // some entities are skipped: without light, or without transform
+        if (i % 7 != 0) {
+            layer.registry.emplace<render::point_light>(
+                entity, render::point_light{ .constant = static_cast<float>(i) }
+            );
+        }
+        if (i % 11 != 0) {
+            layer.registry.emplace<transform>(entity, transform{ .tr{ static_cast<float>(i) } });
+        }
+    }
+
+    std::vector<render::point_light_element> serial(entities.size());
+    const std::uint32_t serial_size = fill_ssbo(layer, world, std::span{ serial }, std::span{ entities });
+
+    worker_pool workers{ 3 };
+    fill_ssbo_chunks<render::point_light_element> chunks;
+    std::vector<render::point_light_element> parallel(entities.size());
+    const std::uint32_t parallel_size =
+        fill_ssbo(layer, world, std::span{ parallel }, std::span<const entt::entity>{ entities }, workers, chunks);
+
+    ASSERT_EQ(parallel_size, serial_size);
+    for (std::uint32_t i = 0; i < serial_size; ++i) {
+        EXPECT_EQ(parallel[i].position, serial[i].position);
+        EXPECT_EQ(parallel[i].constant, serial[i].constant);
+    }
+}
+
+} // namespace
+} // namespace sl::game
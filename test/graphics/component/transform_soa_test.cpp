@@ -0,0 +1,106 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/component/transform_soa.hpp"
+
+#include <glm/gtc/epsilon.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+constexpr float epsilon = 1e-5f;
+
+transform make_transform(std::size_t i) {
+    const float f = static_cast<float>(i);
+    return transform{
+        .tr{ f, -0.5f * f, 2.0f },
+        .rot = glm::normalize(glm::quat{ 1.0f, 0.1f * f, 0.2f, -0.3f * f }),
+        .s{ 1.0f + 0.1f * f, 2.0f, 0.5f },
+    };
+}
+
+void expect_near(const transform& actual, const transform& expected) {
+    EXPECT_TRUE(glm::all(glm::epsilonEqual(actual.tr, expected.tr, epsilon)));
+    EXPECT_TRUE(glm::all(glm::epsilonEqual(actual.rot, expected.rot, epsilon)));
+    EXPECT_TRUE(glm::all(glm::epsilonEqual(actual.s, expected.s, epsilon)));
+}
+
+struct transform_soa_test : ::testing::TestWithParam<std::size_t> {
+    transform_soa parent;
+    transform_soa local;
+
+    void fill(std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            parent.push_back(make_transform(i));
+            local.push_back(make_transform(size - i));
+        }
+    }
+};
+
+TEST_P(transform_soa_test, roundTrips) {
+    fill(GetParam());
+    ASSERT_EQ(parent.size(), GetParam());
+    for (std::size_t i = 0; i < parent.size(); ++i) {
+        expect_near(parent.get(i), make_transform(i));
+    }
+}
+
+TEST_P(transform_soa_test, combineMatchesScalar) {
+    const std::size_t size = GetParam();
+    fill(size);
+
+    // every kernel usable on this cpu, each of them followed by narrower ones for the tail
+    for (const std::size_t max_lane_count : { 1uz, 4uz, 8uz }) {
+        if (max_lane_count > combine_lane_count()) {
+            continue;
+        }
+        SCOPED_TRACE(max_lane_count);
+
+        transform_soa out;
+        std::vector<glm::mat4> models(size);
+        combine(parent, local, out, models, max_lane_count);
+
+        ASSERT_EQ(out.size(), size);
+        for (std::size_t i = 0; i < size; ++i) {
+            const transform expected = combine(parent.get(i), local.get(i));
+            expect_near(out.get(i), expected);
+            for (glm::length_t column = 0; column < 4; ++column) {
+                EXPECT_TRUE(glm::all(glm::epsilonEqual(models[i][column], expected.matrix()[column], 1e-4f)));
+            }
+        }
+    }
+}
+
+TEST_P(transform_soa_test, combineInPlace) {
+    const std::size_t size = GetParam();
+    fill(size);
+    const transform_soa original_local = local;
+
+    combine(parent, local, local, {});
+
+    for (std::size_t i = 0; i < size; ++i) {
+        expect_near(local.get(i), combine(parent.get(i), original_local.get(i)));
+    }
+}
+
+// sizes around lane counts, so that both the vector kernel and its scalar tail are exercised
+INSTANTIATE_TEST_SUITE_P(sizes, transform_soa_test, ::testing::Values(0, 1, 3, 4, 7, 8, 9, 17, 64));
+
+TEST(transform_soa, laneCountIsKnown) {
+    const std::size_t lane_count = combine_lane_count();
+    EXPECT_TRUE(lane_count == 1 || lane_count == 4 || lane_count == 8);
+#if defined(__x86_64__) && !defined(_MSC_VER)
+    // the AVX2 kernel is always built on x86-64, so it is used whenever the cpu has it
+    EXPECT_EQ(lane_count == 8, static_cast<bool>(__builtin_cpu_supports("avx2")));
+#endif
+}
+
+} // namespace
+} // namespace sl::game
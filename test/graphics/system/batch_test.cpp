@@ -0,0 +1,90 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/component/vertex.hpp"
+#include "sl/game/graphics/system/batch.hpp"
+
+#include <sl/meta/storage/unique_string_convenience.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+using meta::operator""_us;
+
+struct draw_batch_cache_test : ::testing::Test {
+    meta::unique_string_storage uss{ meta::unique_string_storage::init_type{} };
+    ecs::layer layer{};
+    draw_batch_cache::ptr_type batches = draw_batch_cache::make(layer.registry);
+
+    const meta::unique_string shader_a = "shader.a"_us(uss);
+    const meta::unique_string vertex_a = "vertex.a"_us(uss);
+    const meta::unique_string vertex_b = "vertex.b"_us(uss);
+
+    entt::entity create(meta::unique_string shader_id, meta::unique_string vertex_id) {
+        const entt::entity entity = layer.registry.create();
+        layer.registry.emplace<shader::id>(entity, shader_id);
+        layer.registry.emplace<vertex::id>(entity, vertex_id);
+        return entity;
+    }
+};
+
+TEST_F(draw_batch_cache_test, groupsByShaderAndVertex) {
+    const entt::entity e0 = create(shader_a, vertex_a);
+    const entt::entity e1 = create(shader_a, vertex_b);
+    const entt::entity e2 = create(shader_a, vertex_a);
+
+    const auto& sv_map = batches->prepare();
+    ASSERT_EQ(sv_map.size(), 1);
+    const auto& v_map = sv_map.at(shader_a);
+    ASSERT_EQ(v_map.size(), 2);
+    EXPECT_EQ(v_map.at(vertex_a).entities, (std::vector{ e0, e2 }));
+    EXPECT_EQ(v_map.at(vertex_b).entities, (std::vector{ e1 }));
+    EXPECT_EQ(batches->size(), 3);
+}
+
+TEST_F(draw_batch_cache_test, keepsEntitiesSortedAfterRemoval) {
+    std::vector<entt::entity> entities;
+    for (int i = 0; i < 8; ++i) {
+        entities.push_back(create(shader_a, vertex_a));
+    }
+    layer.registry.destroy(entities[2]);
+    layer.registry.destroy(entities[5]);
+    std::erase(entities, entities[5]);
+    std::erase(entities, entities[2]);
+
+    const auto& batch = batches->prepare().at(shader_a).at(vertex_a);
+    EXPECT_TRUE(std::ranges::is_sorted(batch.entities));
+    EXPECT_EQ(batch.entities, entities);
+}
+
+TEST_F(draw_batch_cache_test, movesEntityOnUpdate) {
+    const entt::entity entity = create(shader_a, vertex_a);
+    std::ignore = batches->prepare();
+    const std::size_t layout_version = batches->layout_version();
+
+    layer.registry.replace<vertex::id>(entity, vertex_b);
+    const auto& v_map = batches->prepare().at(shader_a);
+    EXPECT_FALSE(v_map.contains(vertex_a));
+    EXPECT_EQ(v_map.at(vertex_b).entities, (std::vector{ entity }));
+    EXPECT_NE(batches->layout_version(), layout_version);
+}
+
+TEST_F(draw_batch_cache_test, layoutVersionIsStableWithoutNewBatches) {
+    create(shader_a, vertex_a);
+    std::ignore = batches->prepare();
+    const std::size_t layout_version = batches->layout_version();
+
+    create(shader_a, vertex_a);
+    std::ignore = batches->prepare();
+    EXPECT_EQ(batches->layout_version(), layout_version);
+}
+
+} // namespace
+} // namespace sl::game
@@ -0,0 +1,184 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/system/spatial.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+struct spatial_index_test : ::testing::Test {
+    entt::registry registry{};
+    spatial_index::ptr_type index = spatial_index::make(registry);
+
+    entt::entity create(const glm::vec3& position, const aabb& box = aabb{ .min{ -0.5f }, .max{ 0.5f } }) {
+        const entt::entity entity = registry.create();
+        registry.emplace<aabb>(entity, box);
+        registry.emplace<transform>(entity, transform{ .tr = position });
+        return entity;
+    }
+
+    void move(entt::entity entity, const glm::vec3& position) {
+        registry.patch<transform>(entity, [&position](transform& tf) { tf.tr = position; });
+    }
+
+    static std::vector<entt::entity> sorted(std::span<const entt::entity> entities) {
+        std::vector<entt::entity> result{ entities.begin(), entities.end() };
+        std::ranges::sort(result);
+        return result;
+    }
+};
+
+TEST_F(spatial_index_test, rayHitsAreSortedByDistance) {
+    const entt::entity far = create({ 0.0f, 0.0f, -10.0f });
+    const entt::entity near = create({ 0.0f, 0.0f, -2.0f });
+    create({ 5.0f, 0.0f, -5.0f });
+    index->update();
+
+    const auto hits = index->query(ray{ .origin{ 0.0f }, .direction{ 0.0f, 0.0f, -1.0f } });
+    EXPECT_EQ(std::vector(hits.begin(), hits.end()), (std::vector{ near, far }));
+
+    const auto short_hits = index->query(ray{ .origin{ 0.0f }, .direction{ 0.0f, 0.0f, -1.0f }, .max_distance = 5.0f });
+    EXPECT_EQ(std::vector(short_hits.begin(), short_hits.end()), (std::vector{ near }));
+}
+
+TEST_F(spatial_index_test, axisAlignedRayGrazesFace) {
+    const entt::entity box = create({ 0.0f, 0.0f, -5.0f });
+    create({ 0.0f, 3.0f, -5.0f });
+    index->update();
+
+    // origin lies on the planes of the top face and of the side face, direction is zero along both
+    const auto grazing = index->query(ray{ .origin{ 0.5f, 0.5f, 0.0f }, .direction{ 0.0f, 0.0f, -1.0f } });
+    EXPECT_EQ(std::vector(grazing.begin(), grazing.end()), (std::vector{ box }));
+
+    const auto missing = index->query(ray{ .origin{ 0.5f, 0.50001f, 0.0f }, .direction{ 0.0f, 0.0f, -1.0f } });
+    EXPECT_TRUE(missing.empty());
+}
+
+TEST_F(spatial_index_test, sphereQueryMatchesBruteForce) {
+    std::vector<entt::entity> inside;
+    for (int x = -10; x <= 10; ++x) {
+        for (int z = -10; z <= 10; ++z) {
+            const glm::vec3 position{ static_cast<float>(x) * 2.0f, 0.0f, static_cast<float>(z) * 2.0f };
+            const entt::entity entity = create(position);
+            // closest point of the box is within the radius
+            const glm::vec3 closest = glm::clamp(glm::vec3{ 3.0f, 0.0f, 1.0f }, position - 0.5f, position + 0.5f);
+            if (glm::distance(closest, glm::vec3{ 3.0f, 0.0f, 1.0f }) <= 4.0f) {
+                inside.push_back(entity);
+            }
+        }
+    }
+    index->update();
+
+    std::ranges::sort(inside);
+    EXPECT_EQ(sorted(index->query(bounding_sphere{ .center{ 3.0f, 0.0f, 1.0f }, .radius = 4.0f })), inside);
+}
+
+TEST_F(spatial_index_test, frustumQuery) {
+    const entt::entity in_front = create({ 0.0f, 0.0f, -5.0f });
+    create({ 0.0f, 0.0f, 5.0f });
+    create({ 100.0f, 0.0f, -5.0f });
+    index->update();
+
+    const camera_frame a_camera_frame{
+        .position{ 0.0f },
+        .projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f),
+        .view = glm::lookAt(glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }),
+    };
+    EXPECT_EQ(sorted(index->query(frustum::from(a_camera_frame))), (std::vector{ in_front }));
+}
+
+TEST_F(spatial_index_test, refitsMovedEntities) {
+    std::vector<entt::entity> entities;
+    for (int i = 0; i < 64; ++i) {
+        entities.push_back(create({ static_cast<float>(i), 0.0f, 0.0f }));
+    }
+    index->update();
+    EXPECT_EQ(index->rebuild_count(), 1);
+
+    // nothing changed
+    index->update();
+    EXPECT_EQ(index->refit_count(), 0);
+
+    move(entities[3], { 3.0f, 0.5f, 0.0f });
+    index->update();
+    EXPECT_EQ(index->refit_count(), 1);
+    EXPECT_EQ(index->rebuild_count(), 1);
+
+    const auto hits = index->query(ray{ .origin{ 3.0f, 10.0f, 0.0f }, .direction{ 0.0f, -1.0f, 0.0f } });
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits.front(), entities[3]);
+}
+
+TEST_F(spatial_index_test, rebuildsOnStructureChange) {
+    create({ 0.0f });
+    index->update();
+    EXPECT_EQ(index->size(), 1);
+
+    const entt::entity added = create({ 10.0f, 0.0f, 0.0f });
+    index->update();
+    EXPECT_EQ(index->size(), 2);
+    EXPECT_EQ(index->rebuild_count(), 2);
+    EXPECT_EQ(
+        sorted(index->query(bounding_sphere{ .center{ 10.0f, 0.0f, 0.0f }, .radius = 1.0f })), (std::vector{ added })
+    );
+
+    registry.destroy(added);
+    index->update();
+    EXPECT_EQ(index->size(), 1);
+}
+
+TEST_F(spatial_index_test, ignoresEntitiesWithoutBounds) {
+    create({ 0.0f });
+    index->update();
+    EXPECT_EQ(index->rebuild_count(), 1);
+
+    // e.g. a light or a group node
+    const entt::entity unbounded = registry.create();
+    registry.emplace<transform>(unbounded, transform{ .tr{ 1.0f, 0.0f, 0.0f } });
+    index->update();
+    registry.destroy(unbounded);
+    index->update();
+    EXPECT_EQ(index->rebuild_count(), 1);
+    EXPECT_EQ(index->size(), 1);
+}
+
+TEST_F(spatial_index_test, rebuildsWhenLoose) {
+    std::vector<entt::entity> entities;
+    for (int i = 0; i < 16; ++i) {
+        entities.push_back(create({ static_cast<float>(i), 0.0f, 0.0f }));
+    }
+    index->update();
+
+    // swap the ends, so that leaves span the whole range
+    move(entities.front(), { 15.0f, 0.0f, 0.0f });
+    move(entities.back(), { 0.0f, 0.0f, 0.0f });
+    for (int i = 1; i < 15; ++i) {
+        move(entities[i], { static_cast<float>(i), static_cast<float>(i % 2) * 100.0f, 0.0f });
+    }
+    index->update();
+    EXPECT_EQ(index->rebuild_count(), 2);
+}
+
+TEST_F(spatial_index_test, pointsDoNotRebuildOnRefit) {
+    const aabb point{ .min{ 0.0f }, .max{ 0.0f } };
+    const entt::entity a = create({ 0.0f }, point);
+    create({ 0.0f }, point);
+    index->update();
+    EXPECT_EQ(index->rebuild_count(), 1);
+
+    move(a, { 1.0f, 1.0f, 1.0f });
+    index->update();
+    EXPECT_EQ(index->refit_count(), 1);
+    EXPECT_EQ(index->rebuild_count(), 1);
+}
+
+} // namespace
+} // namespace sl::game
@@ -0,0 +1,130 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/render/light/cluster.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace sl::game::render {
+namespace {
+
+struct clustered_lights_test : ::testing::Test {
+    cluster_grid grid{ .x = 8, .y = 4, .z = 16 };
+    clustered_lights lights{ grid };
+    camera_frame a_camera_frame{
+        .position{ 0.0f },
+        .projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f),
+        .view = glm::lookAt(glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }),
+    };
+
+    // radius of about 2 units
+    static point_light_element point(const glm::vec3& position) {
+        return point_light_element{
+            .position = position,
+            .ambient{ 1.0f },
+            .diffuse{ 1.0f },
+            .specular{ 1.0f },
+            .constant = 1.0f,
+            .linear = 0.0f,
+            .quadratic = 64.0f,
+        };
+    }
+    static spot_light_element spot(const glm::vec3& position) {
+        return spot_light_element{
+            .position = position,
+            .direction{ 0.0f, 0.0f, -1.0f },
+            .ambient{ 1.0f },
+            .diffuse{ 1.0f },
+            .specular{ 1.0f },
+            .constant = 1.0f,
+            .linear = 0.0f,
+            .quadratic = 64.0f,
+            .cutoff = 0.9f,
+            .outer_cutoff = 0.8f,
+        };
+    }
+
+    // same as the fragment shader
+    std::uint32_t cluster_of(const glm::vec3& world_position) const {
+        const clustered_lights::shader_parameters parameters = lights.parameters();
+        const glm::vec4 view = a_camera_frame.view * glm::vec4{ world_position, 1.0f };
+        const glm::vec4 clip = a_camera_frame.projection * view;
+        const glm::vec2 tile = glm::floor((glm::vec2{ clip } / clip.w * 0.5f + 0.5f) * glm::vec2{ parameters.grid });
+        const float slice = std::floor(std::log(-view.z / parameters.near) * parameters.depth_scale);
+        return grid.index(
+            static_cast<std::uint32_t>(tile.x), static_cast<std::uint32_t>(tile.y), static_cast<std::uint32_t>(slice)
+        );
+    }
+
+    std::vector<std::uint32_t> points_of(std::uint32_t cluster) const {
+        const light_cluster_element& element = lights.clusters()[cluster];
+        const auto indices = lights.indices().subspan(element.point_offset, element.point_count);
+        return { indices.begin(), indices.end() };
+    }
+    std::vector<std::uint32_t> spots_of(std::uint32_t cluster) const {
+        const light_cluster_element& element = lights.clusters()[cluster];
+        const auto indices = lights.indices().subspan(element.spot_offset, element.spot_count);
+        return { indices.begin(), indices.end() };
+    }
+};
+
+TEST_F(clustered_lights_test, listsLightInClustersAroundIt) {
+    const std::vector points{ point({ 0.0f, 0.0f, -10.0f }), point({ 5.0f, 2.0f, -20.0f }) };
+    lights.assign(points, {}, a_camera_frame);
+
+    ASSERT_EQ(lights.clusters().size(), grid.size());
+    EXPECT_EQ(points_of(cluster_of({ 0.0f, 0.0f, -10.0f })), (std::vector<std::uint32_t>{ 0 }));
+    EXPECT_EQ(points_of(cluster_of({ 0.5f, 0.5f, -9.0f })), (std::vector<std::uint32_t>{ 0 }));
+    EXPECT_EQ(points_of(cluster_of({ 5.0f, 2.0f, -20.0f })), (std::vector<std::uint32_t>{ 1 }));
+    // far from both
+    EXPECT_TRUE(points_of(cluster_of({ -20.0f, -10.0f, -30.0f })).empty());
+    EXPECT_TRUE(points_of(cluster_of({ 0.0f, 0.0f, -50.0f })).empty());
+}
+
+TEST_F(clustered_lights_test, skipsLightBehindCamera) {
+    const std::vector points{ point({ 0.0f, 0.0f, 10.0f }) };
+    lights.assign(points, {}, a_camera_frame);
+
+    EXPECT_TRUE(lights.indices().empty());
+}
+
+TEST_F(clustered_lights_test, spotsAreIndexedSeparately) {
+    const std::vector points{ point({ 0.0f, 0.0f, -10.0f }) };
+    const std::vector spots{ spot({ 10.0f, 0.0f, -30.0f }), spot({ 0.0f, 0.0f, -10.0f }) };
+    lights.assign(points, spots, a_camera_frame);
+
+    const std::uint32_t cluster = cluster_of({ 0.0f, 0.0f, -10.0f });
+    EXPECT_EQ(points_of(cluster), (std::vector<std::uint32_t>{ 0 }));
+    EXPECT_EQ(spots_of(cluster), (std::vector<std::uint32_t>{ 1 }));
+}
+
+TEST_F(clustered_lights_test, parallelMatchesSequential) {
+    std::vector<point_light_element> points;
+    for (int i = 0; i < 2000; ++i) {
+        const float f = static_cast<float>(i);
+        points.push_back(point({ std::sin(f) * 30.0f, std::cos(f * 0.7f) * 10.0f, -std::fmod(f, 90.0f) }));
+    }
+
+    lights.assign(points, {}, a_camera_frame);
+    const std::vector clusters(lights.clusters().begin(), lights.clusters().end());
+    const std::vector indices(lights.indices().begin(), lights.indices().end());
+
+    worker_pool workers{ 3 };
+    lights.assign(points, {}, a_camera_frame, &workers);
+    ASSERT_EQ(lights.clusters().size(), clusters.size());
+    for (std::size_t i = 0; i < clusters.size(); ++i) {
+        EXPECT_EQ(lights.clusters()[i].point_offset, clusters[i].point_offset);
+        EXPECT_EQ(lights.clusters()[i].point_count, clusters[i].point_count);
+    }
+    EXPECT_TRUE(std::ranges::equal(lights.indices(), indices));
+}
+
+} // namespace
+} // namespace sl::game::render
@@ -0,0 +1,108 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/graphics/component/transform.hpp"
+#include "sl/game/update/component.hpp"
+#include "sl/game/update/dirty.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+struct dirty_subtrees_test : ::testing::Test {
+    ecs::layer layer{};
+    dirty_subtrees<local_transform>::ptr_type dirty = dirty_subtrees<local_transform>::make(layer);
+
+    entt::entity create(entt::entity parent) {
+        const entt::entity entity = layer.registry.create();
+        layer.registry.emplace<local_transform>(entity, transform{ .tr{} });
+        node::attach_child(layer, parent, entity);
+        return entity;
+    }
+
+    std::vector<entt::entity> release_roots() {
+        const auto roots = dirty->release_roots();
+        std::vector<entt::entity> sorted{ roots.begin(), roots.end() };
+        std::ranges::sort(sorted);
+        return sorted;
+    }
+
+    // what the transform pass does to flags after the roots were released
+    void settle() {
+        std::ignore = dirty->release_roots();
+        for (auto [entity, local_tf] : layer.registry.view<local_transform>().each()) {
+            std::ignore = local_tf.release();
+        }
+    }
+};
+
+TEST_F(dirty_subtrees_test, wholeTreeIsDirtyInitially) {
+    EXPECT_EQ(release_roots(), (std::vector{ layer.root }));
+    EXPECT_TRUE(release_roots().empty());
+}
+
+TEST_F(dirty_subtrees_test, keepsTopmostMarkedEntities) {
+    const entt::entity a = create(layer.root);
+    const entt::entity b = create(a);
+    const entt::entity c = create(b);
+    const entt::entity d = create(layer.root);
+    settle();
+
+    layer.registry.patch<local_transform>(c);
+    layer.registry.patch<local_transform>(b);
+    layer.registry.patch<local_transform>(d);
+    std::vector expected{ b, d };
+    std::ranges::sort(expected);
+    EXPECT_EQ(release_roots(), expected);
+}
+
+TEST_F(dirty_subtrees_test, marksPatchedInPlaceChanges) {
+    const entt::entity a = create(layer.root);
+    const entt::entity b = create(a);
+    settle();
+
+    layer.registry.get<local_transform>(b).set(transform{ .tr{ 1.0f, 0.0f, 0.0f } });
+    layer.registry.patch<local_transform>(b);
+    EXPECT_EQ(release_roots(), (std::vector{ b }));
+}
+
+TEST_F(dirty_subtrees_test, releasesNothingWithoutChanges) {
+    const entt::entity a = create(layer.root);
+    std::ignore = create(a);
+    settle();
+
+    EXPECT_TRUE(release_roots().empty());
+}
+
+TEST_F(dirty_subtrees_test, marksMovedSubtree) {
+    const entt::entity a = create(layer.root);
+    const entt::entity b = create(layer.root);
+    const entt::entity c = create(a);
+    settle();
+
+    node::attach_child(layer, b, c);
+    EXPECT_EQ(release_roots(), (std::vector{ c }));
+    EXPECT_TRUE(layer.registry.get<local_transform>(c).is_dirty());
+}
+
+TEST_F(dirty_subtrees_test, dropsDetachedEntities) {
+    const entt::entity a = create(layer.root);
+    settle();
+
+    node::detach_child(layer, a);
+    layer.registry.patch<local_transform>(a);
+    EXPECT_TRUE(release_roots().empty());
+    EXPECT_TRUE(release_roots().empty());
+
+    node::attach_child(layer, layer.root, a);
+    EXPECT_EQ(release_roots(), (std::vector{ a }));
+}
+
+} // namespace
+} // namespace sl::game
@@ -0,0 +1,149 @@
+//
+// Created by usatiynyan.
+//
+
+#include "sl/game/update/flat_tree.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+namespace sl::game {
+namespace {
+
+struct flat_tree_test : ::testing::Test {
+    entt::registry registry{};
+    flat_tree tree{ registry.create() };
+
+    std::vector<entt::entity> order() const {
+        std::vector<entt::entity> entities;
+        for (const flat_tree::element& element : tree.elements()) {
+            entities.push_back(element.entity);
+        }
+        return entities;
+    }
+
+    // subtree_size and parent of every element have to agree with depth-first order
+    void expect_consistent() const {
+        const std::span<const flat_tree::element> elements = tree.elements();
+        for (flat_tree::index_type i = 0; i < elements.size(); ++i) {
+            const flat_tree::element& element = elements[i];
+            EXPECT_GT(element.subtree_size, 0);
+            EXPECT_LE(i + element.subtree_size, elements.size());
+            if (element.parent == entt::null) {
+                EXPECT_EQ(i, 0);
+                continue;
+            }
+            const auto parent_it = std::find_if(elements.begin(), elements.begin() + i, [&](const auto& x) {
+                return x.entity == element.parent;
+            });
+            ASSERT_NE(parent_it, elements.begin() + i);
+            const auto parent_index = static_cast<flat_tree::index_type>(parent_it - elements.begin());
+            EXPECT_LE(i + element.subtree_size, parent_index + parent_it->subtree_size);
+        }
+    }
+};
+
+TEST_F(flat_tree_test, linearizesDepthFirst) {
+    const entt::entity root = tree.root();
+    const entt::entity a = registry.create();
+    const entt::entity b = registry.create();
+    const entt::entity a0 = registry.create();
+    const entt::entity a1 = registry.create();
+
+    ASSERT_TRUE(tree.attach_children(root, std::span<const entt::entity, 2>{ std::array{ a, b } }));
+    ASSERT_TRUE(tree.attach_child(a, a0));
+    ASSERT_TRUE(tree.attach_child(a, a1));
+
+    EXPECT_EQ(tree.size(), 5);
+    EXPECT_EQ(order(), (std::vector{ root, a, a0, a1, b }));
+    EXPECT_EQ(tree.elements()[1].subtree_size, 3);
+    EXPECT_EQ(tree.first_child(1), 2);
+    EXPECT_EQ(tree.next_sibling(1), 4);
+    EXPECT_EQ(tree.next_sibling(4), flat_tree::npos);
+    EXPECT_EQ(tree.parent(a1).value(), a);
+    EXPECT_FALSE(tree.parent(root).has_value());
+    expect_consistent();
+}
+
+TEST_F(flat_tree_test, movesSubtreeOnReattach) {
+    const entt::entity root = tree.root();
+    const entt::entity a = registry.create();
+    const entt::entity b = registry.create();
+    const entt::entity a0 = registry.create();
+
+    ASSERT_TRUE(tree.attach_child(root, a));
+    ASSERT_TRUE(tree.attach_child(root, b));
+    ASSERT_TRUE(tree.attach_child(a, a0));
+    EXPECT_EQ(order(), (std::vector{ root, a, a0, b }));
+
+    ASSERT_TRUE(tree.attach_child(b, a));
+    EXPECT_EQ(order(), (std::vector{ root, b, a, a0 }));
+    EXPECT_EQ(tree.parent(a).value(), b);
+    expect_consistent();
+}
+
+TEST_F(flat_tree_test, rejectsCycles) {
+    const entt::entity a = registry.create();
+    const entt::entity a0 = registry.create();
+    ASSERT_TRUE(tree.attach_child(tree.root(), a));
+    ASSERT_TRUE(tree.attach_child(a, a0));
+
+    EXPECT_FALSE(tree.attach_child(a0, a));
+    EXPECT_FALSE(tree.attach_child(registry.create(), a0));
+    EXPECT_EQ(tree.parent(a0).value(), a);
+}
+
+TEST_F(flat_tree_test, detachKeepsSubtree) {
+    const entt::entity root = tree.root();
+    const entt::entity a = registry.create();
+    const entt::entity b = registry.create();
+    const entt::entity a0 = registry.create();
+    ASSERT_TRUE(tree.attach_child(root, a));
+    ASSERT_TRUE(tree.attach_child(root, b));
+    ASSERT_TRUE(tree.attach_child(a, a0));
+
+    EXPECT_TRUE(tree.detach_child(a));
+    EXPECT_FALSE(tree.detach_child(root));
+    EXPECT_EQ(order(), (std::vector{ root, b }));
+    EXPECT_EQ(tree.size(), 4);
+    EXPECT_TRUE(tree.contains(a0));
+    EXPECT_FALSE(tree.parent(a).has_value());
+    EXPECT_EQ(tree.parent(a0).value(), a);
+    expect_consistent();
+
+    // detached subtree can still grow and comes back as a whole
+    const entt::entity a1 = registry.create();
+    ASSERT_TRUE(tree.attach_child(a, a1));
+    EXPECT_EQ(order(), (std::vector{ root, b }));
+    ASSERT_TRUE(tree.attach_child(b, a));
+    EXPECT_EQ(order(), (std::vector{ root, b, a, a0, a1 }));
+    expect_consistent();
+}
+
+TEST_F(flat_tree_test, eraseRemovesSubtree) {
+    const entt::entity root = tree.root();
+    const entt::entity a = registry.create();
+    const entt::entity b = registry.create();
+    const entt::entity a0 = registry.create();
+    ASSERT_TRUE(tree.attach_child(root, a));
+    ASSERT_TRUE(tree.attach_child(root, b));
+    ASSERT_TRUE(tree.attach_child(a, a0));
+
+    EXPECT_EQ(tree.erase(a), 2);
+    EXPECT_EQ(tree.erase(root), 0);
+    EXPECT_FALSE(tree.contains(a0));
+    EXPECT_EQ(order(), (std::vector{ root, b }));
+
+    const entt::entity c = registry.create();
+    ASSERT_TRUE(tree.attach_child(b, c));
+    EXPECT_EQ(order(), (std::vector{ root, b, c }));
+    EXPECT_EQ(tree.size(), 3);
+    expect_consistent();
+}
+
+} // namespace
+} // namespace sl::game